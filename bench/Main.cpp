@@ -0,0 +1,261 @@
+#include "Json.hpp"
+#include "Micro.hpp"
+#include "Pipeline.hpp"
+#include "Support.hpp"
+
+#include "zia/module/Handler.hpp"
+#include "zia/module/Parser.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <dlfcn.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+/** @file
+ * Benchmark suite of the module API, running without network.
+ * Replays recorded request corpora through a parser module and a handlers pipeline, with in-memory client
+ * streams, and reports throughput, request latency percentiles and per-stage latencies.
+ * Micro-benchmarks measure the cost of single API calls.
+ * Usage: `zia_bench [--parser PATH] [--handler PATH]... [--fragment BYTES] [--rounds N] [--body BYTES]
+ * [--no-micro] [CORPUS]...`. Handler modules run in order, before a built-in handler answering with a body
+ * of `--body` bytes. Corpora default to the files of `bench/corpus`.
+*/
+
+namespace {
+
+using namespace Zia;
+using namespace Zia::Bench;
+using namespace Zia::Support;
+
+struct Options
+{
+	std::string parser = ZIA_BENCH_PARSER;
+	std::vector<std::string> handlers;
+	size_t fragment = 1460; ///< Typical TCP segment payload
+	size_t rounds = 2000;
+	size_t body = 1024;
+	bool micro = true;
+	std::vector<std::string> corpora;
+};
+
+/**
+* @class Library
+* Module shared library, loaded the way the server does.
+*/
+class Library
+{
+public:
+	explicit Library(const std::string &path) :
+		m_path(path),
+		m_handle(dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL))
+	{
+		if (m_handle == nullptr)
+			throw std::runtime_error(dlerror());
+	}
+
+	~Library(void)
+	{
+		dlclose(m_handle);
+	}
+
+	Library(const Library&) = delete;
+	Library& operator=(const Library&) = delete;
+
+	template <typename Fn>
+	Fn* get(const char *name) const
+	{
+		auto *res = reinterpret_cast<Fn*>(dlsym(m_handle, name));
+
+		if (res == nullptr)
+			throw std::runtime_error(m_path + ": missing symbol " + name);
+		return res;
+	}
+
+private:
+	std::string m_path;
+	void *m_handle;
+};
+
+/**
+* @struct Loaded
+* Module instance, with its library and configuration. Members are destroyed in reverse order.
+* @param typename T: the module kind
+*/
+template <typename T>
+struct Loaded
+{
+	std::unique_ptr<Library> library;
+	std::unique_ptr<Conf> conf;
+	std::unique_ptr<T> module;
+};
+
+template <typename T>
+Loaded<T> load(const std::string &path, const char *factory)
+{
+	Loaded<T> res;
+
+	res.library = std::make_unique<Library>(path);
+	res.conf = std::make_unique<Conf>();
+	res.module.reset(res.library->template get<T* (IConf&)>(factory)(*res.conf));
+	return res;
+}
+
+/**
+* @class Responder
+* Built-in last handler, answering with a fixed page as a file loader would.
+*/
+class Responder : public Module::IHandler
+{
+public:
+	explicit Responder(size_t size) :
+		m_page(std::make_shared<const std::vector<char>>(size, 'x'))
+	{
+	}
+
+	void handle(const IRequest &req, IResponse &res, IContext &ctx, ILogger &log) override
+	{
+		static_cast<void>(req);
+		static_cast<void>(ctx);
+		static_cast<void>(log);
+		if (res.getBody() != nullptr)
+			return;
+		res.setHeader(HeaderId::ContentType, "text/html; charset=utf-8");
+		res.setHeader(HeaderId::CacheControl, "max-age=60");
+		res.setBody(m_page);
+	}
+
+private:
+	SharedBuffer m_page;
+};
+
+std::string readFile(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file)
+		throw std::runtime_error("cannot open " + path);
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void printLatency(const char *name, const Metrics::Histogram &latency)
+{
+	if (latency.getCount() == 0)
+		return;
+	std::printf("  %-24s %10llu %9.2f %9.2f %9.2f %9.2f %9.2f\n", name,
+		static_cast<unsigned long long>(latency.getCount()),
+		static_cast<double>(latency.getSum()) / static_cast<double>(latency.getCount()) / 1e3,
+		latency.getPercentile(50) / 1e3, latency.getPercentile(99) / 1e3, latency.getPercentile(99.9) / 1e3,
+		latency.getMax() / 1e3);
+}
+
+void benchPipeline(Module::IParser &parser, const std::vector<std::pair<std::string, Module::IHandler*>> &handlers,
+	const Options &options, const std::string &name, const std::string &corpus)
+{
+	NullLogger log;
+	NullOutput output;
+	Pipeline pipeline(handlers, log, output);
+	Metrics::Histogram parse;
+	Clock::time_point start = Clock::now();
+
+	for (size_t i = 0; i < options.rounds; i++) {
+		MemoryInput input(corpus, options.fragment);
+		std::unique_ptr<Module::IParser::IInstance> instance = parser.create(input, log, pipeline);
+
+		while (input.feed()) {
+			do {
+				Clock::time_point parseStart = Clock::now();
+				instance->parse();
+				parse.record(static_cast<uint64_t>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - parseStart).count()));
+				pipeline.poll();
+			} while (instance->getReadiness() == Readiness::Paused);
+		}
+	}
+	double secs = std::chrono::duration<double>(Clock::now() - start).count();
+	uint64_t requests = pipeline.getLatency().getCount();
+
+	std::printf("%s: %zu bytes, %llu req/corpus, fragments of %zu bytes\n", name.c_str(), corpus.size(),
+		static_cast<unsigned long long>(requests / options.rounds), options.fragment);
+	std::printf("  %12.0f req/s %10.1f MB/s in %10.1f MB/s out\n", requests / secs,
+		options.rounds * corpus.size() / secs / 1e6, output.getWritten() / secs / 1e6);
+	std::printf("  I/O buffers of %zu bytes: %zu leased at most, from %zu slabs\n", pipeline.getPool().getBufferSize(),
+		pipeline.getPool().getMaxLeased(), pipeline.getPool().getSlabCount());
+	if (pipeline.getPending() != 0)
+		std::printf("  warning: %zu requests left unanswered, is the corpus truncated?\n", pipeline.getPending());
+	std::printf("  %-24s %10s %9s %9s %9s %9s %9s\n", "stage (us)", "calls", "mean", "p50", "p99", "p99.9", "max");
+	printLatency("request", pipeline.getLatency());
+	printLatency("parse", parse);
+	for (const Pipeline::Stage &stage : pipeline.getStages())
+		printLatency(stage.name.c_str(), stage.latency);
+}
+
+Options parseOptions(int argc, char **argv)
+{
+	Options res;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "--parser" && hasValue)
+			res.parser = argv[++i];
+		else if (arg == "--handler" && hasValue)
+			res.handlers.push_back(argv[++i]);
+		else if (arg == "--fragment" && hasValue)
+			res.fragment = std::max<size_t>(1, std::stoul(argv[++i]));
+		else if (arg == "--rounds" && hasValue)
+			res.rounds = std::max<size_t>(1, std::stoul(argv[++i]));
+		else if (arg == "--body" && hasValue)
+			res.body = std::stoul(argv[++i]);
+		else if (arg == "--no-micro")
+			res.micro = false;
+		else if (arg.compare(0, 2, "--") == 0)
+			throw std::runtime_error("unknown option " + arg);
+		else
+			res.corpora.push_back(arg);
+	}
+	if (res.corpora.empty()) {
+		for (const auto &entry : std::filesystem::directory_iterator(ZIA_BENCH_CORPUS_DIR))
+			if (entry.path().extension() == ".http")
+				res.corpora.push_back(entry.path().string());
+		std::sort(res.corpora.begin(), res.corpora.end());
+	}
+	return res;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	try {
+		Options options = parseOptions(argc, argv);
+		Loaded<Module::IParser> parser = load<Module::IParser>(options.parser, "createParser");
+		std::vector<Loaded<Module::IHandler>> modules;
+		std::vector<std::pair<std::string, Module::IHandler*>> handlers;
+		Responder responder(options.body);
+
+		for (const std::string &path : options.handlers) {
+			modules.push_back(load<Module::IHandler>(path, "createHandler"));
+			handlers.emplace_back(std::filesystem::path(path).filename().string(), modules.back().module.get());
+		}
+		handlers.emplace_back("responder", &responder);
+
+		std::vector<std::string> corpora;
+		for (const std::string &path : options.corpora)
+			corpora.push_back(readFile(path));
+		if (options.micro && !corpora.empty()) {
+			runMicroBenchmarks(*parser.module, corpora.front());
+			std::printf("\n");
+		}
+		for (size_t i = 0; i < corpora.size(); i++)
+			benchPipeline(*parser.module, handlers, options, std::filesystem::path(options.corpora[i]).filename().string(),
+				corpora[i]);
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,212 @@
+#include "Micro.hpp"
+#include "BufferPool.hpp"
+#include "Exchange.hpp"
+#include "Json.hpp"
+#include "Pipeline.hpp"
+#include "Support.hpp"
+
+#include <cstdio>
+
+namespace Zia::Bench {
+
+namespace {
+
+using namespace Support;
+
+volatile size_t sink;
+
+// Calls fn iterations times, fn returns a value depending on its work so that it cannot be optimized out
+template <typename Fn>
+void measure(const char *name, size_t iterations, Fn &&fn)
+{
+	size_t res = 0;
+	Clock::time_point start = Clock::now();
+
+	for (size_t i = 0; i < iterations; i++)
+		res += fn();
+	double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(iterations);
+	sink = sink + res;
+	std::printf("  %-52s %10.1f ns/op\n", name, ns);
+}
+
+class CountingVisitor : public IRequest::IFieldVisitor
+{
+public:
+	void visit(std::string_view key, std::string_view value) override
+	{
+		size += key.size() + value.size();
+	}
+
+	size_t size = 0;
+};
+
+void benchHeaders(Module::IParser &parser, const std::string &corpus)
+{
+	constexpr size_t iterations = 1000000;
+	MemoryInput input(corpus, corpus.size());
+	NullLogger log;
+	CapturingEmitter emitter(1);
+	std::unique_ptr<Module::IParser::IInstance> instance = parser.create(input, log, emitter);
+
+	std::printf("headers\n");
+	input.feed();
+	instance->parse();
+	if (emitter.getRequests().empty()) {
+		std::printf("  skipped: the parser emits no request by std::unique_ptr\n");
+		return;
+	}
+	const IRequest &req = *emitter.getRequests().front();
+	const std::string present = "User-Agent";
+	const std::string missing = "X-Missing";
+	measure("IRequest::getHeader(const std::string&)", iterations, [&]() {
+		const std::string *value = req.getHeader(present);
+		return value ? value->size() : 0;
+	});
+	measure("IRequest::findHeader(std::string_view)", iterations, [&]() {
+		return req.findHeader(std::string_view(present)).value_or("").size();
+	});
+	measure("IRequest::findHeader(HeaderId)", iterations, [&]() {
+		return req.findHeader(HeaderId::UserAgent).value_or("").size();
+	});
+	measure("IRequest::getHeader(const std::string&), missing", iterations, [&]() {
+		return static_cast<size_t>(req.getHeader(missing) != nullptr);
+	});
+	measure("IRequest::findHeader(std::string_view), missing", iterations, [&]() {
+		return static_cast<size_t>(req.findHeader(std::string_view(missing)).has_value());
+	});
+	measure("IRequest::getHeaderKeys + getHeader", iterations / 10, [&]() {
+		size_t res = 0;
+		for (const std::string &key : req.getHeaderKeys())
+			res += req.getHeader(key)->size();
+		return res;
+	});
+	measure("IRequest::visitHeaders", iterations / 10, [&]() {
+		CountingVisitor visitor;
+		req.visitHeaders(visitor);
+		return visitor.size;
+	});
+}
+
+void benchContext(void)
+{
+	constexpr size_t iterations = 1000000;
+	static const ContextKey<size_t> key("bench.value");
+	const std::string name = "bench.value";
+	std::pmr::monotonic_buffer_resource arena;
+	Context ctx(arena);
+	size_t value = 0;
+
+	std::printf("context\n");
+	measure("IContext::set(const std::string&, const std::any&)", iterations, [&]() {
+		ctx.set(name, std::any(value++));
+		return size_t(1);
+	});
+	measure("IContext::get(const std::string&) + std::any_cast", iterations, [&]() {
+		return std::any_cast<size_t>(*ctx.get(name));
+	});
+	measure("IContext::set(const ContextKey&)", iterations, [&]() {
+		ctx.set(key, value++);
+		return size_t(1);
+	});
+	measure("IContext::get(const ContextKey&)", iterations, [&]() {
+		return *ctx.get(key);
+	});
+}
+
+void benchConf(void)
+{
+	constexpr size_t routes = 1000;
+	Conf conf;
+	Object &object = conf.edit();
+
+	object.setInteger("max_size", 1024);
+	Json::IObject &table = object.createEmptyObject("routes");
+	for (size_t i = 0; i < routes; i++) {
+		Json::IObject &route = table.createEmptyObject("/route/" + std::to_string(i));
+		route.setString("target", "http://backend-" + std::to_string(i % 16) + ".internal:8080");
+		route.setInteger("weight", static_cast<Json::Integer>(i));
+	}
+	const std::string routeKey = "/route/500";
+
+	std::printf("conf (%zu routes)\n", routes);
+	measure("IConf::read()->getInteger", 1000, [&]() {
+		return static_cast<size_t>(*conf.read()->getInteger("max_size"));
+	});
+	measure("IConf::snapshot()->getInteger", 1000000, [&]() {
+		return static_cast<size_t>(*conf.snapshot()->getInteger("max_size"));
+	});
+	std::shared_ptr<const Json::IObject> snapshot = conf.snapshot();
+	measure("held snapshot, getInteger", 1000000, [&]() {
+		return static_cast<size_t>(*snapshot->getInteger("max_size"));
+	});
+	measure("held snapshot, nested getObject + getInteger", 1000000, [&]() {
+		return static_cast<size_t>(*snapshot->getObject("routes")->getObject(routeKey)->getInteger("weight"));
+	});
+}
+
+void benchBody(void)
+{
+	constexpr size_t iterations = 20000;
+	constexpr size_t handlers = 3;
+	const std::vector<char> page(64 * 1024, 'x');
+	const SharedBuffer shared = std::make_shared<const std::vector<char>>(page);
+
+	std::printf("body (%zu KiB, %zu transforming handlers)\n", page.size() / 1024, handlers);
+	measure("getBody copy + setBody(const std::vector<char>&)", iterations, [&]() {
+		Response res;
+		res.setBody(page);
+		for (size_t i = 0; i < handlers; i++) {
+			std::vector<char> body(*res.getBody());
+			body[i] ^= 1;
+			res.setBody(body);
+		}
+		return res.getBody()->size();
+	});
+	measure("takeBody + setBody(std::vector<char>&&)", iterations, [&]() {
+		Response res;
+		res.setBody(page);
+		for (size_t i = 0; i < handlers; i++) {
+			std::vector<char> body = res.takeBody();
+			body[i] ^= 1;
+			res.setBody(std::move(body));
+		}
+		return res.getBody()->size();
+	});
+	measure("setBody(SharedBuffer), no transform", iterations, [&]() {
+		Response res;
+		res.setBody(shared);
+		return res.getBody()->size();
+	});
+}
+
+void benchBuffers(void)
+{
+	constexpr size_t iterations = 1000000;
+	constexpr size_t size = 16384;
+	SlabPool pool(size);
+
+	std::printf("I/O buffers (%zu KiB)\n", size / 1024);
+	measure("PooledBuffer, allocated", iterations, [&]() {
+		PooledBuffer buf(nullptr, size);
+		buf.data()[0] = 1;
+		return static_cast<size_t>(buf.data()[0]);
+	});
+	measure("PooledBuffer, leased from IBufferPool", iterations, [&]() {
+		PooledBuffer buf(&pool, size);
+		buf.data()[0] = 1;
+		return static_cast<size_t>(buf.data()[0]);
+	});
+}
+
+}
+
+void runMicroBenchmarks(Module::IParser &parser, const std::string &corpus)
+{
+	benchHeaders(parser, corpus);
+	benchContext();
+	benchConf();
+	benchBody();
+	benchBuffers();
+}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "zia/Zia.hpp"
+
+namespace Zia::Bench {
+
+/**
+* @fn runMicroBenchmarks
+* Measure the cost of single API calls: header lookup, context access, configuration reads, body copies
+* and I/O buffer leases.
+* @param Module::IParser &parser: the parser producing the request used for header lookups
+* @param const std::string &corpus: raw requests, the first one is used for header lookups
+*/
+void runMicroBenchmarks(Module::IParser &parser, const std::string &corpus);
+
+}
@@ -0,0 +1,183 @@
+#include "Pipeline.hpp"
+#include "Exchange.hpp"
+
+#include <cstdio>
+#include <ctime>
+
+namespace Zia::Bench {
+
+using namespace Support;
+
+namespace {
+
+uint64_t getNanoseconds(Clock::time_point start, Clock::time_point end)
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+class Completion : public Module::IHandler::ICompletion
+{
+public:
+	void complete(void) override
+	{
+		completed = true;
+	}
+
+	bool completed = false;
+};
+
+}
+
+Pipeline::Arena::Arena(void) :
+	resource(storage.data(), storage.size())
+{
+}
+
+Pipeline::Pipeline(const std::vector<std::pair<std::string, Module::IHandler*>> &handlers, ILogger &log,
+	IOutput &output) :
+	m_log(log),
+	m_output(output),
+	m_arena(std::make_unique<Arena>()),
+	m_discard(16384),
+	m_dateTime(0)
+{
+	for (const auto &handler : handlers)
+		m_stages.push_back(Stage{handler.first, handler.second, handler.second->getFilter(), Metrics::Histogram()});
+	m_stages.push_back(Stage{"write", nullptr, Module::HandlerFilter(), Metrics::Histogram()});
+}
+
+void Pipeline::emit(const IRequest &request)
+{
+	// The request is only valid during the call: answer it right away
+	run(request, m_arena->resource, Clock::now());
+	m_arena->resource.release();
+}
+
+void Pipeline::emit(std::unique_ptr<IRequest> request)
+{
+	m_pending.push_back(Exchange{std::move(request), takeArena(), Clock::now()});
+	poll();
+}
+
+std::pmr::memory_resource& Pipeline::getArena(void)
+{
+	return m_arena->resource;
+}
+
+void Pipeline::wake(void)
+{
+	// The driver calls parse again whenever the parser is paused
+}
+
+IBufferPool* Pipeline::getBufferPool(void)
+{
+	return &m_pool;
+}
+
+void Pipeline::poll(void)
+{
+	for (Exchange &exchange : m_pending) {
+		if (IBodySource *body = exchange.request->getBodySource())
+			while (body->read(m_discard.size(), m_discard.data()) > 0);
+	}
+	while (!m_pending.empty()) {
+		Exchange &exchange = m_pending.front();
+		IBodySource *body = exchange.request->getBodySource();
+		if (body != nullptr && !body->isOver())
+			return;
+		run(*exchange.request, exchange.arena->resource, exchange.emittedAt);
+		exchange.request.reset();
+		recycle(std::move(exchange.arena));
+		m_pending.pop_front();
+	}
+}
+
+const Metrics::Histogram& Pipeline::getLatency(void) const
+{
+	return m_latency;
+}
+
+const std::vector<Pipeline::Stage>& Pipeline::getStages(void) const
+{
+	return m_stages;
+}
+
+size_t Pipeline::getPending(void) const
+{
+	return m_pending.size();
+}
+
+const SlabPool& Pipeline::getPool(void) const
+{
+	return m_pool;
+}
+
+void Pipeline::run(const IRequest &request, std::pmr::memory_resource &arena, Clock::time_point emittedAt)
+{
+	Response res;
+	size_t called = 0;
+
+	{
+		Context ctx(arena);
+		for (; called + 1 < m_stages.size() && !res.isAborted(); called++) {
+			Stage &stage = m_stages[called];
+			if (!stage.filter.matches(request))
+				continue;
+			Completion completion;
+			Clock::time_point start = Clock::now();
+			stage.handler->handleAsync(request, res, ctx, m_log, completion);
+			stage.latency.record(getNanoseconds(start, Clock::now()));
+			if (!completion.completed && m_log.isEnabled(LogLevel::Error))
+				m_log.log(LogRecord{LogLevel::Error, std::chrono::system_clock::now(), 0,
+					"bench: handler {} did not complete synchronously, which is not supported", {stage.name}});
+		}
+		while (called-- > 0)
+			if (m_stages[called].filter.matches(request))
+				m_stages[called].handler->finalize(request, res, ctx, m_log);
+	}
+	Clock::time_point start = Clock::now();
+	bool written = res.write(m_output, getDate(), m_pool);
+	Clock::time_point end = Clock::now();
+	if (!written && m_log.isEnabled(LogLevel::Error))
+		m_log.log(LogRecord{LogLevel::Error, std::chrono::system_clock::now(), 0,
+			"bench: response to {} cut short, the server would close the connection", {request.getURL()}});
+	m_stages.back().latency.record(getNanoseconds(start, end));
+	m_latency.record(getNanoseconds(emittedAt, end));
+}
+
+std::unique_ptr<Pipeline::Arena> Pipeline::takeArena(void)
+{
+	std::unique_ptr<Arena> res = std::move(m_arena);
+
+	if (m_freeArenas.empty())
+		m_arena = std::make_unique<Arena>();
+	else {
+		m_arena = std::move(m_freeArenas.back());
+		m_freeArenas.pop_back();
+	}
+	return res;
+}
+
+void Pipeline::recycle(std::unique_ptr<Arena> arena)
+{
+	arena->resource.release();
+	m_freeArenas.push_back(std::move(arena));
+}
+
+std::string_view Pipeline::getDate(void)
+{
+	time_t now = std::time(nullptr);
+
+	// Formatted once per second, as the server does
+	if (now != m_dateTime) {
+		char buf[64];
+		std::tm tm;
+		gmtime_r(&now, &tm);
+		size_t size = std::strftime(buf, sizeof(buf), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+		m_date.assign(buf, size);
+		m_dateTime = now;
+	}
+	return m_date;
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "BufferPool.hpp"
+
+#include <array>
+#include <deque>
+
+/**
+* @namespace Zia::Bench
+* Benchmark suite of the module API: pipeline driver, buffer pool and micro-benchmarks.
+*/
+namespace Zia::Bench {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+* @class Pipeline
+* Request emitter running the handlers pipeline on each emitted request, then writing its response.
+* Streamed request bodies are consumed before the pipeline runs, and responses are written in emission order.
+*/
+class Pipeline : public IRequest::IEmitter
+{
+public:
+	/**
+	* @struct Stage
+	* A pipeline stage, timed across all requests.
+	*/
+	struct Stage
+	{
+		std::string name;
+		Module::IHandler *handler; ///< nullptr for the response write
+		Module::HandlerFilter filter;
+		Metrics::Histogram latency; ///< Nanoseconds per call
+	};
+
+	/**
+	* @fn Pipeline
+	* Create a pipeline.
+	* @param const std::vector<std::pair<std::string, Module::IHandler*>> &handlers: named handlers, in conf-order
+	* @param ILogger &log: the logger given to handlers
+	* @param IOutput &output: the client output
+	*/
+	Pipeline(const std::vector<std::pair<std::string, Module::IHandler*>> &handlers, ILogger &log, IOutput &output);
+
+	void emit(const IRequest &request) override;
+	void emit(std::unique_ptr<IRequest> request) override;
+	std::pmr::memory_resource& getArena(void) override;
+	void wake(void) override;
+	IBufferPool* getBufferPool(void) override;
+
+	/**
+	* @fn poll
+	* Consume the body bytes received for streamed requests, and run the requests whose body is complete.
+	*/
+	void poll(void);
+
+	/**
+	* @fn getLatency
+	* Get the latency of requests, from emission to response write, in nanoseconds.
+	* @return const Metrics::Histogram&: the request latencies
+	*/
+	const Metrics::Histogram& getLatency(void) const;
+
+	const std::vector<Stage>& getStages(void) const;
+
+	/**
+	* @fn getPending
+	* Get the amount of emitted requests not answered yet, waiting for their body.
+	* @return size_t: the amount of pending requests
+	*/
+	size_t getPending(void) const;
+
+	const Support::SlabPool& getPool(void) const;
+
+private:
+	struct Arena
+	{
+		Arena(void);
+
+		std::array<char, 8192> storage;
+		std::pmr::monotonic_buffer_resource resource;
+	};
+
+	struct Exchange
+	{
+		std::unique_ptr<IRequest> request;
+		std::unique_ptr<Arena> arena;
+		Clock::time_point emittedAt;
+	};
+
+	ILogger &m_log;
+	IOutput &m_output;
+	Support::SlabPool m_pool;
+	std::vector<Stage> m_stages; ///< Handlers in conf-order, then the response write
+	Metrics::Histogram m_latency;
+	std::unique_ptr<Arena> m_arena; ///< Arena of the next emitted request
+	std::vector<std::unique_ptr<Arena>> m_freeArenas;
+	std::deque<Exchange> m_pending;
+	std::vector<char> m_discard;
+	time_t m_dateTime;
+	std::string m_date;
+
+	void run(const IRequest &request, std::pmr::memory_resource &arena, Clock::time_point emittedAt);
+	std::unique_ptr<Arena> takeArena(void);
+	void recycle(std::unique_ptr<Arena> arena);
+	std::string_view getDate(void);
+};
+
+}
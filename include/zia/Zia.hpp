@@ -1,14 +1,23 @@
 #pragma once
 
 #include <cstdint>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <vector>
 #include <map>
 #include <optional>
 #include <any>
 #include <type_traits>
+#include <utility>
 #include <tuple>
+#include <variant>
 
 /**
 * @namespace Zia
@@ -26,28 +35,102 @@ namespace Zia {
  * I - ILogger
  * The server accepts an arbitrary amount of loggers in conf. Upon a logged line, all loggers will be
  * called with such data as parameter.
+ * Logged lines are pushed into per-thread lock-free queues, and a background thread drains them in batches
+ * to the loggers, so that a slow logger never delays requests.
+ * Records are structured (level, timestamp, connection id, format string and typed arguments) and only formatted
+ * by loggers needing text. Records below the minimum level declared by all loggers are dropped early.
  * 
  * II - IConnectionWrapper
  * The client connects to the server. A IConnection marked as default is created. If a single
  * IConnectionWrapper module is activated by conf, a new connection will be created around the base
  * connection using this module. The resulting connection becomes the default connection for
  * reading / writing from the client.
+ * A TLS wrapper that offloads encryption to the kernel (kTLS) after the handshake reports it through
+ * isNativeSocketPlaintext(), which lets the server keep writing with sendfile / splice.
  * 
  * III - IParser
  * As the client connects, a parser instance is created from the parser module selected by configuration.
- * The server will regularely call IParser::IInstance::parse() to parse available bytes and make the parser
- * pass requests to the handlers.
+ * The server calls IParser::IInstance::parse() to parse available bytes and make the parser
+ * pass requests to the handlers. Parsers and connections report what they wait for through getReadiness():
+ * parse() is then only called once the client socket is readable. Modules that do not report readiness
+ * are polled regularly instead.
+ * Parsers emitting requests by std::unique_ptr give their ownership to the server, so that pipelined requests
+ * can be handled concurrently. Responses are still written in the order requests were emitted.
+ * A parser can emit a request as soon as its headers are parsed, exposing its body as a stream
+ * (IRequest::getBodySource()). The client is then only read as fast as handlers consume that stream.
+ * Client timeouts (idle, header, body) are picked from IParser::IInstance::getPhase() and kept in a
+ * hierarchical timer wheel per shard, so that arming, re-arming and cancelling them is O(1).
+ * The body timeout is suspended while the parser is paused by a handler applying backpressure.
+ * Kept-alive connections idle for a while are hibernated: the parser instance and the wrapped connection
+ * release their buffers (hibernate()), leaving a few hundred bytes per idle client.
+ * I/O buffers come from a per-shard pool of fixed-size slabs (IBufferPool), reachable from
+ * IRequest::IEmitter::getBufferPool() and IConnection::getBufferPool(). Parsers, connection wrappers and
+ * the response writer lease them only while bytes are in flight.
  * 
  * IV - IHandler
  * The server accepts an arbitrary amount of handlers in conf.
  * When a request is received, the server calls all handlers in conf-order.
+ * Handlers declaring a filter (methods, path prefixes, extensions) are skipped for requests not matching it.
  * Each handler can modify the response header and response body. When an handler
  * calls abortPipeline on the request, this marks the last handler and no more handler
  * will be called in the handlers pipeline.
+ * A handler can also process a request asynchronously through handleAsync(): the request is then suspended
+ * until the handler notifies completion, while the server keeps serving other connections.
+ * Once the pipeline is over, the server calls finalize() on every handler that was called, in reverse order.
  * After last handler, the response is written to client default connection.
+ * The response head is written along with the start of the body in a single vectored write,
+ * from precomputed status lines, a Date header refreshed once per second and pre-serialized header blocks.
+ * The response body is pulled incrementally from its source as the client connection accepts more bytes,
+ * so handlers can stream bodies instead of holding them entirely in memory.
+ * 
+ * V - IMetricsSink
+ * The server accepts an arbitrary amount of metrics sinks in conf.
+ * Every module call is timed into per-shard latency histograms, along with traffic and error counters.
+ * They are merged periodically into a snapshot, handed to all sinks from a background thread.
+ * 
+ * THREADING MODEL
+ * The server runs one reactor thread per shard, each with its own listening socket bound with SO_REUSEPORT.
+ * A client connection, and everything created for it, stays on a single shard.
+ * Module factories are called once per shard, so a module instance is never called concurrently.
+ * A module exporting getModuleThreading() returning Module::Threading::Shared is created only once
+ * and called from all shards concurrently.
  * 
  */
 
+/**
+* @struct Buffer
+* Mutable memory region, used for scatter reads.
+*/
+struct Buffer
+{
+	char *data;
+	size_t size;
+};
+
+/**
+* @struct ConstBuffer
+* Immutable memory region, used for gather writes and borrowed reads.
+*/
+struct ConstBuffer
+{
+	const char *data;
+	size_t size;
+};
+
+/**
+* @enum Readiness
+* What a connection or a parser instance waits for before it can make progress.
+* The server watches the native client socket accordingly (epoll or equivalent reactor)
+* and only calls back into the module once the awaited event occurred.
+*/
+enum class Readiness
+{
+	Ready, ///< Can make progress right away, the server calls back without waiting
+	NeedInput, ///< Waits for the native socket to become readable
+	NeedOutput, ///< Waits for the native socket to become writable
+	Paused ///< Waits for another party (e.g. a handler reading a request body), the module notifies the server when resumed
+};
+
 /**
 * @interface IInput
 * Non-blocking input stream.
@@ -65,6 +148,50 @@ public:
 	* @return size_t: the amount of bytes polled from the stream and written into buf
 	*/
 	virtual size_t read(size_t buf_size, char *buf) = 0;
+
+	/**
+	* @fn readv
+	* Read available bytes on the stream into several buffers, filling them in order.
+	* @param size_t bufs_count: amount of buffers at bufs
+	* @param const Buffer *bufs: buffers to write stream available bytes to
+	* @return size_t: the total amount of bytes polled from the stream and written into bufs
+	* @note Default implementation calls `read` on each buffer until one is not filled entirely.
+	*/
+	virtual size_t readv(size_t bufs_count, const Buffer *bufs)
+	{
+		size_t res = 0;
+
+		for (size_t i = 0; i < bufs_count; i++) {
+			size_t got = read(bufs[i].size, bufs[i].data);
+			res += got;
+			if (got < bufs[i].size)
+				break;
+		}
+		return res;
+	}
+
+	/**
+	* @fn borrow
+	* Get a view on available bytes, directly in the stream receive buffer, without copying them.
+	* Bytes stay available on the stream until `release` is called.
+	* @return ConstBuffer: the available bytes. `data` is nullptr when the stream does not support borrowing,
+	* in which case `read` must be used instead.
+	* @note The view is invalidated by any subsequent call to `read`, `readv`, `borrow` or `release`.
+	*/
+	virtual ConstBuffer borrow(void)
+	{
+		return ConstBuffer{nullptr, 0};
+	}
+
+	/**
+	* @fn release
+	* Consume bytes previously viewed with `borrow`.
+	* @param size_t size: amount of bytes to consume, at most the size of the last borrowed view
+	*/
+	virtual void release(size_t size)
+	{
+		static_cast<void>(size);
+	}
 };
 
 /**
@@ -89,6 +216,28 @@ public:
 	* also take that into consideration.
 	*/
 	virtual size_t write(size_t buf_size, const char *buf) = 0;
+
+	/**
+	* @fn writev
+	* Write bytes from several buffers on the stream, in order.
+	* @param size_t bufs_count: amount of buffers at bufs
+	* @param const ConstBuffer *bufs: buffers with bytes that will be written on the stream
+	* @return size_t: the total amount of bytes actually written on the stream
+	* @note Same availability considerations as `write` apply.
+	* Default implementation calls `write` on each buffer until one is not written entirely.
+	*/
+	virtual size_t writev(size_t bufs_count, const ConstBuffer *bufs)
+	{
+		size_t res = 0;
+
+		for (size_t i = 0; i < bufs_count; i++) {
+			size_t written = write(bufs[i].size, bufs[i].data);
+			res += written;
+			if (written < bufs[i].size)
+				break;
+		}
+		return res;
+	}
 };
 
 /**
@@ -101,9 +250,270 @@ public:
 	virtual ~IInputOutput(void) override = default;
 };
 
+/**
+* @interface IBufferPool
+* Pool of fixed-size I/O buffers, provided by the server.
+* Each shard owns its pool: buffers are carved from slabs allocated on the NUMA node of the shard,
+* and recycled through a free list, so that leasing and releasing a buffer never reaches the allocator.
+* Parsers, connection wrappers and the response writer lease buffers only while bytes are in flight,
+* and release them as soon as they are drained.
+* @note A pool must only be used from the shard thread it was obtained on.
+*/
+class IBufferPool
+{
+public:
+	virtual ~IBufferPool(void) = default;
+
+	/**
+	* @fn getBufferSize
+	* Get the size of the buffers of the pool.
+	* @return size_t: the buffer size in bytes, 16384 by default (see `"buffers"` server conf)
+	*/
+	virtual size_t getBufferSize(void) const = 0;
+
+	/**
+	* @fn lease
+	* Take a buffer from the pool. A new slab is allocated when no buffer is free.
+	* @return char*: the buffer, `getBufferSize()` bytes long, with unspecified content
+	*/
+	virtual char* lease(void) = 0;
+
+	/**
+	* @fn release
+	* Give a buffer back to the pool.
+	* @param char *buffer: a buffer previously returned by `lease` on the same pool
+	*/
+	virtual void release(char *buffer) = 0;
+};
+
+/**
+* @class PooledBuffer
+* Owning handle of an I/O buffer, leased from a pool when one is available and large enough,
+* allocated otherwise. The buffer is given back on destruction or `reset`.
+*/
+class PooledBuffer
+{
+public:
+	PooledBuffer(void) = default;
+
+	/**
+	* @fn PooledBuffer
+	* Lease a buffer.
+	* @param IBufferPool *pool: the pool to lease from, nullptr to allocate the buffer
+	* @param size_t size: the minimal buffer size
+	*/
+	PooledBuffer(IBufferPool *pool, size_t size) :
+		m_size(size)
+	{
+		if (pool != nullptr && pool->getBufferSize() >= size) {
+			m_pool = pool;
+			m_data = pool->lease();
+		} else
+			m_data = new char[size];
+	}
+
+	PooledBuffer(PooledBuffer &&other) noexcept :
+		m_pool(std::exchange(other.m_pool, nullptr)),
+		m_data(std::exchange(other.m_data, nullptr)),
+		m_size(std::exchange(other.m_size, 0))
+	{
+	}
+
+	PooledBuffer& operator=(PooledBuffer &&other) noexcept
+	{
+		if (this != &other) {
+			reset();
+			m_pool = std::exchange(other.m_pool, nullptr);
+			m_data = std::exchange(other.m_data, nullptr);
+			m_size = std::exchange(other.m_size, 0);
+		}
+		return *this;
+	}
+
+	PooledBuffer(const PooledBuffer&) = delete;
+	PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+	~PooledBuffer(void)
+	{
+		reset();
+	}
+
+	/**
+	* @fn reset
+	* Give the buffer back, leaving the handle empty.
+	*/
+	void reset(void)
+	{
+		if (m_pool != nullptr)
+			m_pool->release(m_data);
+		else
+			delete[] m_data;
+		m_pool = nullptr;
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	char* data(void) const
+	{
+		return m_data;
+	}
+
+	/**
+	* @fn size
+	* Get the usable size of the buffer, the size asked for on construction.
+	* @return size_t: the buffer size, 0 when empty
+	*/
+	size_t size(void) const
+	{
+		return m_size;
+	}
+
+	bool empty(void) const
+	{
+		return m_data == nullptr;
+	}
+
+	/**
+	* @fn isPooled
+	* Check whether the buffer was leased from a pool, and is therefore cheap to give back and lease again.
+	* @return bool: true if leased from a pool
+	*/
+	bool isPooled(void) const
+	{
+		return m_pool != nullptr;
+	}
+
+private:
+	IBufferPool *m_pool = nullptr;
+	char *m_data = nullptr;
+	size_t m_size = 0;
+};
+
+/**
+* @enum LogLevel
+* Severity of a log record.
+*/
+enum class LogLevel : uint8_t
+{
+	Debug,
+	Info,
+	Warning,
+	Error
+};
+
+/**
+* @fn getLogLevelName
+* Get the lowercase name of a log level. Ex: `"warning"`.
+* @param LogLevel level: the log level
+* @return std::string_view: the name of the level
+*/
+inline std::string_view getLogLevelName(LogLevel level)
+{
+	static constexpr std::string_view names[] = {"debug", "info", "warning", "error"};
+
+	return names[static_cast<size_t>(level)];
+}
+
+/**
+* @class LogArgument
+* Typed argument of a log record, only turned into text when the record is formatted.
+*/
+class LogArgument
+{
+public:
+	template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+	LogArgument(T value) :
+		m_value(static_cast<int64_t>(value))
+	{
+	}
+
+	LogArgument(double value) :
+		m_value(value)
+	{
+	}
+
+	LogArgument(const char *value) :
+		m_value(std::string(value))
+	{
+	}
+
+	LogArgument(std::string_view value) :
+		m_value(std::string(value))
+	{
+	}
+
+	LogArgument(std::string value) :
+		m_value(std::move(value))
+	{
+	}
+
+	/**
+	* @fn getValue
+	* Get the typed value of the argument.
+	* @return const std::variant<int64_t, double, std::string>&: the value
+	*/
+	const std::variant<int64_t, double, std::string>& getValue(void) const
+	{
+		return m_value;
+	}
+
+	/**
+	* @fn toString
+	* Format the argument as text.
+	* @return std::string: the formatted argument
+	*/
+	std::string toString(void) const
+	{
+		if (auto *str = std::get_if<std::string>(&m_value))
+			return *str;
+		if (auto *integer = std::get_if<int64_t>(&m_value))
+			return std::to_string(*integer);
+		return std::to_string(std::get<double>(m_value));
+	}
+
+private:
+	std::variant<int64_t, double, std::string> m_value;
+};
+
+/**
+* @struct LogRecord
+* Structured log record. Formatting is deferred to the loggers, which might never need it.
+*/
+struct LogRecord
+{
+	LogLevel level;
+	std::chrono::system_clock::time_point timestamp;
+	uint64_t connectionId; ///< Id of the connection the record relates to, 0 if none
+	const char *format; ///< Format string with static storage duration, each `{}` is replaced by the next argument
+	std::vector<LogArgument> arguments;
+};
+
+/**
+* @fn formatLogRecord
+* Format the message of a log record, replacing each `{}` in its format string by the next argument.
+* @param const LogRecord &record: the record to format
+* @return std::string: the formatted message
+*/
+inline std::string formatLogRecord(const LogRecord &record)
+{
+	std::string res;
+	size_t arg = 0;
+
+	for (const char *it = record.format; *it != '\0'; it++) {
+		if (it[0] == '{' && it[1] == '}' && arg < record.arguments.size()) {
+			res += record.arguments[arg++].toString();
+			it++;
+		} else
+			res += *it;
+	}
+	return res;
+}
+
 /**
 * @interface ILogger
 * Abstract logging system.
+* Logger modules are only called from the server log thread, which drains in batches the lines
+* queued by all shards. Logging on the request path only queues the line and never waits for logger modules.
 */
 class ILogger
 {
@@ -116,6 +526,71 @@ public:
 	* @param const std::string &str: the string to log
 	*/
 	virtual void log(const std::string &str) = 0;
+
+	/**
+	* @fn log
+	* Log several strings to the logging stream at once, in order.
+	* @param size_t count: amount of strings at strs
+	* @param const std::string *strs: the strings to log
+	* @note Default implementation logs each string separately. Loggers writing to a file
+	* should override it to write the whole batch at once (e.g. with a single `writev`).
+	*/
+	virtual void log(size_t count, const std::string *strs)
+	{
+		for (size_t i = 0; i < count; i++)
+			log(strs[i]);
+	}
+
+	/**
+	* @fn getMinLevel
+	* Get the minimum level of records this logger is interested in.
+	* Records below the minimum level of all loggers are dropped before being formatted.
+	* @return LogLevel: the minimum level
+	*/
+	virtual LogLevel getMinLevel(void) const
+	{
+		return LogLevel::Debug;
+	}
+
+	/**
+	* @fn isEnabled
+	* Check whether records of a certain level would be logged, to skip building them otherwise.
+	* @param LogLevel level: the level to check
+	* @return bool: true if such records are logged, false otherwise
+	*/
+	bool isEnabled(LogLevel level) const
+	{
+		return level >= getMinLevel();
+	}
+
+	/**
+	* @fn log
+	* Log a structured record to the logging stream.
+	* @param const LogRecord &record: the record to log
+	* @note Default implementation formats the record and logs it as a string, prefixed by its level.
+	*/
+	virtual void log(const LogRecord &record)
+	{
+		std::string str = "[";
+
+		str += getLogLevelName(record.level);
+		str += "] ";
+		str += formatLogRecord(record);
+		log(str);
+	}
+
+	/**
+	* @fn log
+	* Log several structured records to the logging stream at once, in order.
+	* @param size_t count: amount of records at records
+	* @param const LogRecord *records: the records to log
+	* @note Default implementation logs each record separately.
+	*/
+	virtual void log(size_t count, const LogRecord *records)
+	{
+		for (size_t i = 0; i < count; i++)
+			log(records[i]);
+	}
 };
 
 /**
@@ -141,8 +616,310 @@ public:
 	* @return int: the file descriptor
 	*/
 	virtual int getNativeSocket(void) const = 0;
+
+	/**
+	* @fn getReadiness
+	* Get what the connection waits for before `read` or `write` can transfer more bytes.
+	* Queried by the server after a `read` or `write` call transferred less bytes than requested.
+	* A wrapped connection might for example need output during a handshake, or be `Ready`
+	* while it still holds decoded bytes in its own buffers.
+	* @return Readiness: the awaited event
+	* @note Default implementation returns `Ready`, which makes the server poll the connection regularly.
+	*/
+	virtual Readiness getReadiness(void) const
+	{
+		return Readiness::Ready;
+	}
+
+	/**
+	* @fn isNativeSocketPlaintext
+	* Check whether bytes written to the native socket are sent to the client as is.
+	* True for the base connection, and for a wrapped connection whose encryption was handed to the kernel
+	* after the handshake (Linux kTLS, `setsockopt(SOL_TLS)`).
+	* When true, the server may write the response directly on the native socket and use
+	* its fast paths (`sendfile(2)`, `splice(2)`, vectored writes).
+	* @return bool: true if the native socket carries plaintext semantics, false otherwise
+	* @note Reading still goes through `read`, so that a wrapper can handle TLS control records.
+	* Default implementation returns false.
+	*/
+	virtual bool isNativeSocketPlaintext(void) const
+	{
+		return false;
+	}
+
+	/**
+	* @fn hibernate
+	* Release the memory held for a client that went idle, e.g. TLS record buffers.
+	* Called by the server on wrapped connections, along with `IParser::IInstance::hibernate`,
+	* when no byte is buffered on either side. The connection must keep working afterwards.
+	* @return bool: true if memory was released
+	* @note Default implementation releases nothing and returns false.
+	*/
+	virtual bool hibernate(void)
+	{
+		return false;
+	}
+
+	/**
+	* @fn getBufferPool
+	* Get the I/O buffer pool of the shard serving the connection.
+	* A connection wrapper leases its record buffers from the pool of the connection it wraps,
+	* and forwards it from its own connection.
+	* @return IBufferPool*: the pool, nullptr if none is available
+	* @note Default implementation returns nullptr.
+	*/
+	virtual IBufferPool* getBufferPool(void)
+	{
+		return nullptr;
+	}
+};
+
+/**
+* @struct FileRange
+* Range of bytes within an open file.
+*/
+struct FileRange
+{
+	int fd;
+	size_t offset;
+	size_t size;
+};
+
+/**
+* @interface IBodySource
+* Non-blocking producer of body bytes, pulled incrementally by its reader.
+* Bytes are obtained through `IInput::read`, which returns 0 when no bytes are ready yet.
+* The reader only pulls as fast as it can write further, which provides backpressure to the producer.
+*/
+class IBodySource : public IInput
+{
+public:
+	virtual ~IBodySource(void) override = default;
+
+	/**
+	* @fn getSize
+	* Get the total amount of bytes this source produces, when known in advance.
+	* @return std::optional<size_t>: the body size, std::nullopt when unknown
+	* @note An unknown size makes the response use chunked transfer encoding.
+	*/
+	virtual std::optional<size_t> getSize(void) const = 0;
+
+	/**
+	* @fn isOver
+	* Check whether all bytes have been produced and read from this source.
+	* @return bool: true when no more bytes will ever be read, false otherwise
+	* @note The body is complete only if the source is over without being aborted (see `isAborted`).
+	*/
+	virtual bool isOver(void) const = 0;
+
+	/**
+	* @fn isAborted
+	* Check whether the source ended before producing the whole body, e.g. on a request body framing error
+	* or a client disconnection. An aborted source is over as well: no more bytes will be read.
+	* @return bool: true if the body is truncated, false otherwise
+	* @note Handlers storing a body (uploads, caches) must discard it when aborted: the size of a chunked
+	* body is unknown, so truncation cannot be detected otherwise.
+	* Default implementation returns false.
+	*/
+	virtual bool isAborted(void) const
+	{
+		return false;
+	}
+
+	/**
+	* @interface IListener
+	* Receives notifications from a body source.
+	*/
+	class IListener
+	{
+	public:
+		virtual ~IListener(void) = default;
+
+		/**
+		* @fn onAvailable
+		* Called when bytes became available on the source, or when the source became over.
+		*/
+		virtual void onAvailable(void) = 0;
+	};
+
+	/**
+	* @fn setListener
+	* Set the listener notified when `read` can make progress again after it returned 0.
+	* @param IListener *listener: the listener, nullptr to remove it
+	* @note Default implementation does nothing: the reader has to poll the source.
+	*/
+	virtual void setListener(IListener *listener)
+	{
+		static_cast<void>(listener);
+	}
+
+	/**
+	* @fn getFile
+	* Get the file range this source produces, if it is backed by a file.
+	* When the native socket of the default connection is plaintext (see `IConnection::isNativeSocketPlaintext`),
+	* the server transmits that range in kernel space with `sendfile(2)` / `splice(2)` and never calls `read`
+	* on this source. Otherwise (e.g. a userspace TLS wrapper is active), bytes are obtained through `read` as usual.
+	* @return std::optional<FileRange>: the file range, std::nullopt when the source is not backed by a file
+	* @note The file descriptor stays owned by the source and must remain open until the source is destroyed.
+	* `getSize` must return the size of the range.
+	*/
+	virtual std::optional<FileRange> getFile(void) const
+	{
+		return std::nullopt;
+	}
 };
 
+/**
+* @enum HeaderId
+* Well-known HTTP header names, for fast header access by index.
+* Headers outside of this list are still reachable through string-keyed accessors.
+*/
+enum class HeaderId : uint8_t
+{
+	Accept,
+	AcceptCharset,
+	AcceptEncoding,
+	AcceptLanguage,
+	AcceptRanges,
+	Age,
+	Allow,
+	Authorization,
+	CacheControl,
+	Connection,
+	ContentDisposition,
+	ContentEncoding,
+	ContentLanguage,
+	ContentLength,
+	ContentLocation,
+	ContentRange,
+	ContentType,
+	Cookie,
+	Date,
+	ETag,
+	Expect,
+	Expires,
+	Host,
+	IfMatch,
+	IfModifiedSince,
+	IfNoneMatch,
+	IfRange,
+	IfUnmodifiedSince,
+	KeepAlive,
+	LastModified,
+	Location,
+	Origin,
+	Pragma,
+	Range,
+	Referer,
+	RetryAfter,
+	Server,
+	SetCookie,
+	TransferEncoding,
+	Upgrade,
+	UserAgent,
+	Vary,
+	Via,
+	WWWAuthenticate,
+	XForwardedFor,
+	Count ///< Amount of well-known headers, not an actual header
+};
+
+/**
+* @fn getHeaderName
+* Get the canonical name of a well-known header. Ex: `"Content-Type"`.
+* @param HeaderId id: the well-known header
+* @return std::string_view: the canonical header name
+*/
+inline std::string_view getHeaderName(HeaderId id)
+{
+	static constexpr std::string_view names[static_cast<size_t>(HeaderId::Count)] = {
+		"Accept",
+		"Accept-Charset",
+		"Accept-Encoding",
+		"Accept-Language",
+		"Accept-Ranges",
+		"Age",
+		"Allow",
+		"Authorization",
+		"Cache-Control",
+		"Connection",
+		"Content-Disposition",
+		"Content-Encoding",
+		"Content-Language",
+		"Content-Length",
+		"Content-Location",
+		"Content-Range",
+		"Content-Type",
+		"Cookie",
+		"Date",
+		"ETag",
+		"Expect",
+		"Expires",
+		"Host",
+		"If-Match",
+		"If-Modified-Since",
+		"If-None-Match",
+		"If-Range",
+		"If-Unmodified-Since",
+		"Keep-Alive",
+		"Last-Modified",
+		"Location",
+		"Origin",
+		"Pragma",
+		"Range",
+		"Referer",
+		"Retry-After",
+		"Server",
+		"Set-Cookie",
+		"Transfer-Encoding",
+		"Upgrade",
+		"User-Agent",
+		"Vary",
+		"Via",
+		"WWW-Authenticate",
+		"X-Forwarded-For",
+	};
+
+	return names[static_cast<size_t>(id)];
+}
+
+/**
+* @fn equalsIgnoreCase
+* Compare two strings, ignoring the case of ASCII letters, as HTTP does for header names and tokens.
+* @param std::string_view a: the first string
+* @param std::string_view b: the second string
+* @return bool: true if both strings are equal ignoring case
+*/
+inline bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+	auto toLower = [](char c) {
+		return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+	};
+
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < a.size(); i++)
+		if (toLower(a[i]) != toLower(b[i]))
+			return false;
+	return true;
+}
+
+/**
+* @fn findHeaderId
+* Find the well-known header matching a name, case-insensitively.
+* Meant to be called once per header at parse time, so that the parsed request stores
+* well-known headers in fixed slots under their canonical name.
+* @param std::string_view name: the header name, in any case. Ex: `"content-type"`
+* @return std::optional<HeaderId>: the matching well-known header, std::nullopt if none
+*/
+inline std::optional<HeaderId> findHeaderId(std::string_view name)
+{
+	for (size_t i = 0; i < static_cast<size_t>(HeaderId::Count); i++)
+		if (equalsIgnoreCase(getHeaderName(static_cast<HeaderId>(i)), name))
+			return static_cast<HeaderId>(i);
+	return std::nullopt;
+}
+
 /**
 * @interface IRequest
 * Abstract HTTP request.
@@ -224,6 +1001,119 @@ public:
 	*/
 	virtual const std::vector<char>* getBody(void) const = 0;
 
+	/**
+	* @fn getBodySource
+	* Query request body as a stream. Returns non-null if the request was emitted before its body was
+	* entirely received, null otherwise. In that case, `getBody` returns null.
+	* Bytes are read from the client only as fast as the stream is consumed.
+	* Handlers can reject the request (e.g. authentication, size limit) without reading the body at all.
+	* @return IBodySource*: the optional body stream
+	* @note The stream must only be read from the shard thread of the request.
+	* Default implementation returns null.
+	*/
+	virtual IBodySource* getBodySource(void) const
+	{
+		return nullptr;
+	}
+
+	/**
+	* @fn findArgument
+	* Query an argument without allocating. Returns a view on the value if found, std::nullopt otherwise.
+	* @param std::string_view name: the name of the argument to query
+	* @return std::optional<std::string_view>: the optional argument, valid as long as the request
+	* @note Default implementation forwards to `getArgument`. Parsers should override it
+	* to return views directly into the received bytes.
+	*/
+	virtual std::optional<std::string_view> findArgument(std::string_view name) const
+	{
+		const std::string *res = getArgument(std::string(name));
+
+		if (res == nullptr)
+			return std::nullopt;
+		return std::string_view(*res);
+	}
+
+	/**
+	* @fn findHeader
+	* Query a header parameter without allocating. Returns a view on the value if found, std::nullopt otherwise.
+	* @param std::string_view key: the key of the parameter to query. Ex: `"Connection"`
+	* @return std::optional<std::string_view>: the optional parameter, valid as long as the request
+	* @note Default implementation forwards to `getHeader`. Parsers should override it
+	* to return views directly into the received bytes.
+	*/
+	virtual std::optional<std::string_view> findHeader(std::string_view key) const
+	{
+		const std::string *res = getHeader(std::string(key));
+
+		if (res == nullptr)
+			return std::nullopt;
+		return std::string_view(*res);
+	}
+
+	/**
+	* @fn findHeader
+	* Query a well-known header parameter. Returns a view on the value if found, std::nullopt otherwise.
+	* @param HeaderId id: the well-known header to query. Ex: `HeaderId::Connection`
+	* @return std::optional<std::string_view>: the optional parameter, valid as long as the request
+	* @note Default implementation looks the canonical header name up. Parsers should override it
+	* with a fixed-slot table filled at parse time.
+	*/
+	virtual std::optional<std::string_view> findHeader(HeaderId id) const
+	{
+		return findHeader(getHeaderName(id));
+	}
+
+	/**
+	* @interface IFieldVisitor
+	* Receives key-value pairs of a request, such as headers or arguments.
+	*/
+	class IFieldVisitor
+	{
+	public:
+		virtual ~IFieldVisitor(void) = default;
+
+		/**
+		* @fn visit
+		* Visit a key-value pair.
+		* @param std::string_view key: the key of the pair
+		* @param std::string_view value: the value of the pair
+		* @note Views are only guaranteed to be valid during the call.
+		*/
+		virtual void visit(std::string_view key, std::string_view value) = 0;
+	};
+
+	/**
+	* @fn visitArguments
+	* Iterate over all arguments without allocating.
+	* @param IFieldVisitor &visitor: the visitor called for each argument
+	* @note Default implementation relies on `getArgumentsKeys` and `getArgument`.
+	*/
+	virtual void visitArguments(IFieldVisitor &visitor) const
+	{
+		for (const std::string &key : getArgumentsKeys()) {
+			const std::string *value = getArgument(key);
+
+			if (value != nullptr)
+				visitor.visit(key, *value);
+		}
+	}
+
+	/**
+	* @fn visitHeaders
+	* Iterate over all header parameters without allocating.
+	* @param IFieldVisitor &visitor: the visitor called for each header parameter
+	* @note Default implementation relies on `getHeaderKeys` and `getHeader`.
+	*/
+	virtual void visitHeaders(IFieldVisitor &visitor) const
+	{
+		for (const std::string &key : getHeaderKeys()) {
+			const std::string *value = getHeader(key);
+
+			if (value != nullptr)
+				visitor.visit(key, *value);
+		}
+	}
+
 	/**
 	* @interface IEmitter
 	* Represents an incoming requests receiver.
@@ -239,12 +1129,203 @@ public:
 		* @param const Request &request: the emitted request
 		*/
 		virtual void emit(const IRequest &request) = 0;
+
+		/**
+		* @fn emit
+		* Emit a request, transferring its ownership to the server.
+		* The server may then handle it while the parser keeps parsing further pipelined requests.
+		* Responses are always written in emission order.
+		* @param std::unique_ptr<IRequest> request: the emitted request
+		* @note The request must stay valid on its own: any view it returns must not point into
+		* parser buffers that get reused. Allocating its storage in the arena given by `getArena` ensures that.
+		* Default implementation emits the request by reference, then destroys it.
+		*/
+		virtual void emit(std::unique_ptr<IRequest> request)
+		{
+			emit(static_cast<const IRequest&>(*request));
+		}
+
+		/**
+		* @fn getArena
+		* Get the per-request arena, where the request being parsed should allocate its storage
+		* (headers, arguments, body) using `std::pmr` containers.
+		* @return std::pmr::memory_resource&: the monotonic arena of the next emitted request
+		* @note The arena is owned by the server and released in one shot once the response
+		* to the emitted request is written. After each `emit`, a fresh arena is returned.
+		*/
+		virtual std::pmr::memory_resource& getArena(void) = 0;
+
+		/**
+		* @fn wake
+		* Notify the server that the parser instance, which reported `Readiness::Paused`, can make progress again.
+		* `parse` will be called soon after.
+		* @note Must be called from the shard thread of the parser instance.
+		*/
+		virtual void wake(void) = 0;
+
+		/**
+		* @fn getBufferPool
+		* Get the I/O buffer pool of the shard serving the client, to lease the parser receive buffer from.
+		* @return IBufferPool*: the pool, nullptr if none is available
+		* @note Default implementation returns nullptr: the parser allocates its own buffers.
+		*/
+		virtual IBufferPool* getBufferPool(void)
+		{
+			return nullptr;
+		}
 	};
 };
 
+/**
+* @fn getStatusLine
+* Get the precomputed HTTP/1.1 status line of a status code, CRLF included. Ex: `"HTTP/1.1 404 Not Found\r\n"`.
+* @param size_t code: the status code
+* @return std::string_view: the status line, empty if the code is not a standard one
+*/
+inline std::string_view getStatusLine(size_t code)
+{
+	static constexpr std::pair<size_t, std::string_view> lines[] = {
+		{100, "HTTP/1.1 100 Continue\r\n"},
+		{101, "HTTP/1.1 101 Switching Protocols\r\n"},
+		{200, "HTTP/1.1 200 OK\r\n"},
+		{201, "HTTP/1.1 201 Created\r\n"},
+		{202, "HTTP/1.1 202 Accepted\r\n"},
+		{203, "HTTP/1.1 203 Non-Authoritative Information\r\n"},
+		{204, "HTTP/1.1 204 No Content\r\n"},
+		{205, "HTTP/1.1 205 Reset Content\r\n"},
+		{206, "HTTP/1.1 206 Partial Content\r\n"},
+		{300, "HTTP/1.1 300 Multiple Choices\r\n"},
+		{301, "HTTP/1.1 301 Moved Permanently\r\n"},
+		{302, "HTTP/1.1 302 Found\r\n"},
+		{303, "HTTP/1.1 303 See Other\r\n"},
+		{304, "HTTP/1.1 304 Not Modified\r\n"},
+		{307, "HTTP/1.1 307 Temporary Redirect\r\n"},
+		{308, "HTTP/1.1 308 Permanent Redirect\r\n"},
+		{400, "HTTP/1.1 400 Bad Request\r\n"},
+		{401, "HTTP/1.1 401 Unauthorized\r\n"},
+		{402, "HTTP/1.1 402 Payment Required\r\n"},
+		{403, "HTTP/1.1 403 Forbidden\r\n"},
+		{404, "HTTP/1.1 404 Not Found\r\n"},
+		{405, "HTTP/1.1 405 Method Not Allowed\r\n"},
+		{406, "HTTP/1.1 406 Not Acceptable\r\n"},
+		{407, "HTTP/1.1 407 Proxy Authentication Required\r\n"},
+		{408, "HTTP/1.1 408 Request Timeout\r\n"},
+		{409, "HTTP/1.1 409 Conflict\r\n"},
+		{410, "HTTP/1.1 410 Gone\r\n"},
+		{411, "HTTP/1.1 411 Length Required\r\n"},
+		{412, "HTTP/1.1 412 Precondition Failed\r\n"},
+		{413, "HTTP/1.1 413 Payload Too Large\r\n"},
+		{414, "HTTP/1.1 414 URI Too Long\r\n"},
+		{415, "HTTP/1.1 415 Unsupported Media Type\r\n"},
+		{416, "HTTP/1.1 416 Range Not Satisfiable\r\n"},
+		{417, "HTTP/1.1 417 Expectation Failed\r\n"},
+		{421, "HTTP/1.1 421 Misdirected Request\r\n"},
+		{422, "HTTP/1.1 422 Unprocessable Entity\r\n"},
+		{426, "HTTP/1.1 426 Upgrade Required\r\n"},
+		{428, "HTTP/1.1 428 Precondition Required\r\n"},
+		{429, "HTTP/1.1 429 Too Many Requests\r\n"},
+		{431, "HTTP/1.1 431 Request Header Fields Too Large\r\n"},
+		{500, "HTTP/1.1 500 Internal Server Error\r\n"},
+		{501, "HTTP/1.1 501 Not Implemented\r\n"},
+		{502, "HTTP/1.1 502 Bad Gateway\r\n"},
+		{503, "HTTP/1.1 503 Service Unavailable\r\n"},
+		{504, "HTTP/1.1 504 Gateway Timeout\r\n"},
+		{505, "HTTP/1.1 505 HTTP Version Not Supported\r\n"},
+	};
+	size_t begin = 0;
+	size_t end = sizeof(lines) / sizeof(*lines);
+
+	// Lines are sorted by code
+	while (begin < end) {
+		size_t mid = (begin + end) / 2;
+
+		if (lines[mid].first < code)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	if (begin == sizeof(lines) / sizeof(*lines) || lines[begin].first != code)
+		return std::string_view();
+	return lines[begin].second;
+}
+
+/**
+* @fn getReasonPhrase
+* Get the reason phrase of a status code. Ex: `"Not Found"`.
+* @param size_t code: the status code
+* @return std::string_view: the reason phrase, empty if the code is not a standard one
+*/
+inline std::string_view getReasonPhrase(size_t code)
+{
+	std::string_view line = getStatusLine(code);
+
+	// Strip `"HTTP/1.1 404 "` and the trailing CRLF
+	return line.empty() ? line : line.substr(13, line.size() - 15);
+}
+
+/**
+* @typedef SharedBuffer
+* Immutable, reference-counted buffer. Can be shared between responses of several connections without copying.
+*/
+using SharedBuffer = std::shared_ptr<const std::vector<char>>;
+
+/**
+* @fn makeHeaderBlock
+* Serialize header parameters once into a block, to attach to many responses with `IResponse::addHeaderBlock`.
+* @param const std::vector<std::pair<std::string, std::string>> &headers: the header parameters, in order
+* @return SharedBuffer: the serialized `"Key: value\r\n"` lines
+*/
+inline SharedBuffer makeHeaderBlock(const std::vector<std::pair<std::string, std::string>> &headers)
+{
+	std::vector<char> res;
+	size_t size = 0;
+
+	for (const auto &header : headers)
+		size += header.first.size() + header.second.size() + 4;
+	res.reserve(size);
+	for (const auto &header : headers) {
+		res.insert(res.end(), header.first.begin(), header.first.end());
+		res.push_back(':');
+		res.push_back(' ');
+		res.insert(res.end(), header.second.begin(), header.second.end());
+		res.push_back('\r');
+		res.push_back('\n');
+	}
+	return std::make_shared<const std::vector<char>>(std::move(res));
+}
+
+/**
+* @fn parseHeaderBlock
+* Read the header parameters back from a block made with `makeHeaderBlock`.
+* @param const std::vector<char> &block: the serialized `"Key: value\r\n"` lines
+* @return std::vector<std::pair<std::string, std::string>>: the header parameters, in order
+*/
+inline std::vector<std::pair<std::string, std::string>> parseHeaderBlock(const std::vector<char> &block)
+{
+	std::vector<std::pair<std::string, std::string>> res;
+	std::string_view lines(block.data(), block.size());
+
+	while (!lines.empty()) {
+		size_t end = lines.find("\r\n");
+		std::string_view line = lines.substr(0, end);
+		size_t colon = line.find(':');
+
+		if (colon != std::string_view::npos) {
+			std::string_view value = line.substr(colon + 1);
+			while (!value.empty() && value.front() == ' ')
+				value.remove_prefix(1);
+			res.emplace_back(std::string(line.substr(0, colon)), std::string(value));
+		}
+		lines.remove_prefix(end == std::string_view::npos ? lines.size() : end + 2);
+	}
+	return res;
+}
+
 /**
 * @interface IResponse
 * Abstract HTTP response.
+* The server writes the response head in a single vectored write: precomputed status line (`getStatusLine`),
+* `Date` header formatted once per second, header parameters, then header blocks.
 */
 class IResponse
 {
@@ -288,6 +1369,54 @@ public:
 	*/
 	virtual void setHeader(const std::string &key, const std::string &value) = 0;
 
+	/**
+	* @fn getHeader
+	* Query a well-known header parameter. Returns non-null if found, null otherwise.
+	* @param HeaderId id: the well-known header to query. Ex: `HeaderId::ContentType`
+	* @return const std::string*: the optional parameter
+	* @note Default implementation looks the canonical header name up.
+	*/
+	virtual const std::string* getHeader(HeaderId id) const
+	{
+		return getHeader(std::string(getHeaderName(id)));
+	}
+
+	/**
+	* @fn setHeader
+	* Sets a well-known header parameter, under its canonical name.
+	* @param HeaderId id: the well-known header to set. Ex: `HeaderId::ContentType`
+	* @param const std::string &value: the value of the parameter to set. Ex: `"application/json"`
+	* @note Default implementation sets the header by its canonical name.
+	*/
+	virtual void setHeader(HeaderId id, const std::string &value)
+	{
+		setHeader(std::string(getHeaderName(id)), value);
+	}
+
+	/**
+	* @fn setHeader
+	* Sets a header parameter, taking ownership of key and value instead of copying them.
+	* @param std::string &&key: the key of the parameter to set. Ex: `"content-type"`
+	* @param std::string &&value: the value of the parameter to set. Ex: `"application/json"`
+	* @note Default implementation copies them with `setHeader(const std::string&, const std::string&)`.
+	*/
+	virtual void setHeader(std::string &&key, std::string &&value)
+	{
+		setHeader(static_cast<const std::string&>(key), static_cast<const std::string&>(value));
+	}
+
+	/**
+	* @fn setHeader
+	* Sets a well-known header parameter, under its canonical name, taking ownership of the value.
+	* @param HeaderId id: the well-known header to set. Ex: `HeaderId::ContentType`
+	* @param std::string &&value: the value of the parameter to set. Ex: `"application/json"`
+	* @note Default implementation sets the header by its canonical name.
+	*/
+	virtual void setHeader(HeaderId id, std::string &&value)
+	{
+		setHeader(std::string(getHeaderName(id)), std::move(value));
+	}
+
 	/**
 	* @fn getBody
 	* Query response body. Returns non-null if present, null otherwise.
@@ -301,11 +1430,150 @@ public:
 	* @param const std::vector<char> &body: the buffer to set for body data
 	*/
 	virtual void setBody(const std::vector<char> &body) = 0;
+
+	/**
+	* @fn setBody
+	* Set response body, taking ownership of the buffer instead of copying it.
+	* @param std::vector<char> &&body: the buffer to set for body data
+	* @note Default implementation copies the buffer with `setBody(const std::vector<char>&)`.
+	*/
+	virtual void setBody(std::vector<char> &&body)
+	{
+		setBody(static_cast<const std::vector<char>&>(body));
+	}
+
+	/**
+	* @fn takeBody
+	* Take ownership of the response body buffer, leaving an empty body in place.
+	* Lets transforming handlers work on the body in place, then give it back with `setBody(std::vector<char>&&)`,
+	* instead of copying it out and in. A body set as a source is not taken, see `takeBodySource`,
+	* and a body set from a SharedBuffer is copied out, as other responses may share it.
+	* @return std::vector<char>: the body data, empty if the response has no body buffer
+	* @note Default implementation copies the body out.
+	*/
+	virtual std::vector<char> takeBody(void)
+	{
+		const std::vector<char> *body = getBody();
+
+		if (body == nullptr)
+			return std::vector<char>();
+		std::vector<char> res(*body);
+		setBody(std::vector<char>());
+		return res;
+	}
+
+	/**
+	* @fn setBodySource
+	* Set response body as a source, pulled incrementally by the server when writing the response.
+	* Replaces any body previously set. `getBody` returns nullptr as long as a source is set.
+	* @param std::unique_ptr<IBodySource> source: the source producing body data
+	*/
+	virtual void setBodySource(std::unique_ptr<IBodySource> source) = 0;
+
+	/**
+	* @fn takeBodySource
+	* Take ownership of the current response body as a source, leaving the response without body.
+	* A body set with `setBody` is returned as a source reading that buffer.
+	* Typically used by transforming handlers: take the upstream source, wrap it into a source
+	* applying the transform on the fly, then give it back with `setBodySource`.
+	* @return std::unique_ptr<IBodySource>: the body source, nullptr if the response has no body
+	*/
+	virtual std::unique_ptr<IBodySource> takeBodySource(void) = 0;
+
+	/**
+	* @fn visitHeaders
+	* Iterate over all header parameters set on the response.
+	* @param IRequest::IFieldVisitor &visitor: the visitor called for each header parameter
+	*/
+	virtual void visitHeaders(IRequest::IFieldVisitor &visitor) const = 0;
+
+	/**
+	* @fn setBody
+	* Set response body from a shared immutable buffer, which is written to the client without being copied.
+	* Replaces any body previously set.
+	* @param SharedBuffer body: the buffer to set for body data
+	* @note Default implementation copies the buffer with `setBody(const std::vector<char>&)`.
+	*/
+	virtual void setBody(SharedBuffer body)
+	{
+		setBody(*body);
+	}
+
+	/**
+	* @fn addHeaderBlock
+	* Attach pre-serialized header parameters, written verbatim after the ones set with `setHeader`.
+	* Meant for headers shared by many responses (e.g. security headers, or cached responses), which are
+	* then serialized once instead of on every response. The block is not parsed: its parameters are not
+	* seen by `getHeader` nor `visitHeaders`, and must not also be set with `setHeader`.
+	* @param SharedBuffer block: `"Key: value\r\n"` lines, see `makeHeaderBlock`
+	* @note Default implementation parses the block and sets each parameter with `setHeader`.
+	*/
+	virtual void addHeaderBlock(SharedBuffer block)
+	{
+		for (auto &header : parseHeaderBlock(*block))
+			setHeader(std::move(header.first), std::move(header.second));
+	}
+
+	/**
+	* @fn getHeaderBlocks
+	* Get the header blocks attached with `addHeaderBlock`, for handlers that need every header of the response
+	* (e.g. a cache storing it). Read them with `parseHeaderBlock`.
+	* @return std::vector<SharedBuffer>: the blocks, in order
+	* @note Default implementation returns no block, as the default `addHeaderBlock` sets parameters instead.
+	*/
+	virtual std::vector<SharedBuffer> getHeaderBlocks(void) const
+	{
+		return {};
+	}
+};
+
+class IContext;
+
+/**
+* @class ContextKey
+* Typed key to a context slot, for fast handler-to-handler handoff without string hashing nor std::any.
+* Declare one per value kind at module scope, ex: `static const Zia::ContextKey<User> userKey("auth.user");`.
+* Modules sharing a value must use the same name and type.
+* @param typename T: the type of the value stored under this key
+*/
+template <typename T>
+class ContextKey
+{
+public:
+	/**
+	* @fn ContextKey
+	* Create a key. The slot is resolved on first use.
+	* @param std::string name: the unique name of the slot. Ex: `"auth.user"`
+	*/
+	explicit ContextKey(std::string name) :
+		m_name(std::move(name)),
+		m_slot(npos)
+	{
+	}
+
+	/**
+	* @fn getName
+	* Get the unique name of the slot.
+	* @return const std::string&: the name of the slot
+	*/
+	const std::string& getName(void) const
+	{
+		return m_name;
+	}
+
+private:
+	friend class IContext;
+
+	static constexpr size_t npos = static_cast<size_t>(-1);
+
+	std::string m_name;
+	mutable std::atomic<size_t> m_slot;
 };
 
 /**
 * @interface IContext
 * Abstract context values. They are stored by std::string keys, value is a std::any.
+* Typed slots addressed by ContextKey are also available for frequent values.
 */
 class IContext
 {
@@ -327,6 +1595,99 @@ public:
 	* @param const const std::any &value: value of context parameter to set
 	*/
 	virtual void set(const std::string &key, const std::any &value) = 0;
+
+	/**
+	* @fn getArena
+	* Get the per-request arena. It also backs the response and the context values storage.
+	* Handlers can allocate per-request objects from it using `std::pmr` containers or allocators.
+	* @return std::pmr::memory_resource&: the monotonic arena of the request
+	* @note Deallocations are no-ops: all memory is released in one shot once the response is written.
+	* Destructors of objects allocated there are not run by the arena itself.
+	*/
+	virtual std::pmr::memory_resource& getArena(void) = 0;
+
+	/**
+	* @fn getSlotIndex
+	* Resolve a slot name to its index. The first call for a name registers the slot.
+	* The index is the same for all contexts, for the whole server lifetime.
+	* @param const std::string &name: the unique name of the slot
+	* @return size_t: the slot index
+	* @note Must be safe to call concurrently. Prefer the ContextKey based methods, which cache the index.
+	*/
+	virtual size_t getSlotIndex(const std::string &name) const = 0;
+
+	/**
+	* @fn getSlot
+	* Get the value stored at a slot. Returns non-null if present, null otherwise.
+	* @param size_t index: the slot index
+	* @return void*: the optional value
+	*/
+	virtual void* getSlot(size_t index) const = 0;
+
+	/**
+	* @fn setSlot
+	* Store a value at a slot, replacing any previous one.
+	* @param size_t index: the slot index
+	* @param void *value: the value to store
+	* @param void (*destroy)(void *value): called on the value when it gets replaced or when the context
+	* is destroyed, nullptr if nothing needs to be done
+	*/
+	virtual void setSlot(size_t index, void *value, void (*destroy)(void *value)) = 0;
+
+	/**
+	* @fn get
+	* Get a typed context value. Returns non-null if present, null otherwise.
+	* @param const ContextKey<T> &key: key of the slot to retrieve
+	* @return T*: the optional context value
+	*/
+	template <typename T>
+	T* get(const ContextKey<T> &key) const
+	{
+		return static_cast<T*>(getSlot(resolve(key)));
+	}
+
+	/**
+	* @fn emplace
+	* Construct a typed context value in the request arena, replacing any previous value.
+	* @param const ContextKey<T> &key: key of the slot to set
+	* @param Args &&...args: arguments forwarded to the T constructor
+	* @return T&: the constructed value
+	*/
+	template <typename T, typename ...Args>
+	T& emplace(const ContextKey<T> &key, Args &&...args)
+	{
+		T *res = new (getArena().allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+		setSlot(resolve(key), res, [](void *value) {
+			static_cast<T*>(value)->~T();
+		});
+		return *res;
+	}
+
+	/**
+	* @fn set
+	* Set a typed context value, replacing any previous value.
+	* @param const ContextKey<T> &key: key of the slot to set
+	* @param T value: value to set
+	*/
+	template <typename T>
+	void set(const ContextKey<T> &key, T value)
+	{
+		emplace(key, std::move(value));
+	}
+
+private:
+	template <typename T>
+	size_t resolve(const ContextKey<T> &key) const
+	{
+		size_t res = key.m_slot.load(std::memory_order_relaxed);
+
+		if (res == ContextKey<T>::npos) {
+			res = getSlotIndex(key.m_name);
+			key.m_slot.store(res, std::memory_order_relaxed);
+		}
+		return res;
+	}
 };
 
 /**
@@ -617,8 +1978,260 @@ public:
 	* @param const Json::IObject &jsonObject: the object containing the data to use for conf
 	*/
 	virtual void write(const Json::IObject &jsonObject) = 0;
+
+	/**
+	* @fn snapshot
+	* Get the current configuration as an immutable snapshot, without copying it.
+	* A snapshot never changes once handed out, and is shared by all its holders, from any thread.
+	* Each generation has its own: on reload or write, a new snapshot is swapped in atomically, and holders
+	* of the previous one keep reading it, unaffected, until they release it.
+	* Prefer it to `read` for large configurations, or when reading configuration on the request path.
+	* @return std::shared_ptr<const Json::IObject>: configuration data
+	* @note Default implementation wraps a fresh `read`.
+	*/
+	virtual std::shared_ptr<const Json::IObject> snapshot(void) const
+	{
+		return read();
+	}
+
+	/**
+	* @fn getGeneration
+	* Get the generation of the configuration, incremented each time it is reloaded or written.
+	* Lets modules caching values derived from the configuration cheaply detect a reload and take a new `snapshot`.
+	* @return uint64_t: the configuration generation
+	* @note Default implementation returns 0, the configuration is then never reloaded.
+	*/
+	virtual uint64_t getGeneration(void) const
+	{
+		return 0;
+	}
+};
+
+/**
+* @namespace Metrics
+* Server instrumentation, consumed by IMetricsSink modules.
+* The server times every module call and counts traffic in per-shard counters, without any synchronization
+* on the request path. Counters are merged into a Snapshot periodically, off the shards.
+*/
+namespace Metrics {
+
+/**
+* @enum Stage
+* Stage of the core flow, timed for each module involved.
+*/
+enum class Stage : uint8_t
+{
+	Accept, ///< Accepting a client connection, core only
+	Wrap, ///< IConnectionWrapper::create
+	Parse, ///< IParser::IInstance::parse
+	Handle, ///< IHandler::handleAsync, up to completion
+	Finalize, ///< IHandler::finalize
+	Write, ///< Writing the response, core only
+	Count ///< Amount of stages, not an actual stage
+};
+
+/**
+* @fn getStageName
+* Get the name of a stage. Ex: `"parse"`.
+* @param Stage stage: the stage
+* @return std::string_view: the stage name
+*/
+inline std::string_view getStageName(Stage stage)
+{
+	static constexpr std::string_view names[static_cast<size_t>(Stage::Count)] = {
+		"accept",
+		"wrap",
+		"parse",
+		"handle",
+		"finalize",
+		"write"
+	};
+
+	return names[static_cast<size_t>(stage)];
+}
+
+/**
+* @class Histogram
+* Log-linear histogram (HDR-style): values are counted in buckets with a relative width of at most 1/16,
+* over the whole 64-bit range, so that recording is a few instructions and percentiles stay accurate.
+* Not thread-safe: the server records into per-shard histograms, then merges them.
+*/
+class Histogram
+{
+public:
+	static constexpr size_t subBucketsLog2 = 4;
+	static constexpr size_t subBuckets = size_t(1) << subBucketsLog2;
+	static constexpr size_t bucketCount = (64 - subBucketsLog2 + 1) * subBuckets;
+
+	/**
+	* @fn record
+	* Count a value.
+	* @param uint64_t value: the value, ex: a latency in nanoseconds
+	* @param uint64_t count: how many times the value occurred
+	*/
+	void record(uint64_t value, uint64_t count = 1)
+	{
+		m_buckets[getBucket(value)] += count;
+		m_count += count;
+		m_sum += value * count;
+		m_max = std::max(m_max, value);
+	}
+
+	/**
+	* @fn merge
+	* Add all the values counted by another histogram.
+	* @param const Histogram &other: the histogram to merge
+	*/
+	void merge(const Histogram &other)
+	{
+		for (size_t i = 0; i < bucketCount; i++)
+			m_buckets[i] += other.m_buckets[i];
+		m_count += other.m_count;
+		m_sum += other.m_sum;
+		m_max = std::max(m_max, other.m_max);
+	}
+
+	/**
+	* @fn getPercentile
+	* Get the value below which a given percentage of values fall.
+	* @param double percentile: the percentage, ex: `99.9`
+	* @return uint64_t: the upper bound of the bucket holding the percentile, 0 if no value was recorded
+	*/
+	uint64_t getPercentile(double percentile) const
+	{
+		double rank = percentile / 100.0 * static_cast<double>(m_count);
+		uint64_t seen = 0;
+
+		for (size_t i = 0; i < bucketCount; i++) {
+			seen += m_buckets[i];
+			if (seen > 0 && static_cast<double>(seen) >= rank)
+				return std::min(getBucketUpperBound(i), m_max);
+		}
+		return m_max;
+	}
+
+	uint64_t getCount(void) const
+	{
+		return m_count;
+	}
+
+	uint64_t getSum(void) const
+	{
+		return m_sum;
+	}
+
+	uint64_t getMax(void) const
+	{
+		return m_max;
+	}
+
+	/**
+	* @fn getBuckets
+	* Get raw bucket counts, for exporters needing the whole distribution.
+	* @return const std::array<uint64_t, bucketCount>&: the count of each bucket, see `getBucketLowerBound`
+	*/
+	const std::array<uint64_t, bucketCount>& getBuckets(void) const
+	{
+		return m_buckets;
+	}
+
+	/**
+	* @fn getBucket
+	* Get the bucket counting a value.
+	* @param uint64_t value: the value
+	* @return size_t: the bucket index
+	*/
+	static size_t getBucket(uint64_t value)
+	{
+		if (value < subBuckets)
+			return static_cast<size_t>(value);
+#if defined(__GNUC__)
+		size_t msb = 63 - static_cast<size_t>(__builtin_clzll(value));
+#else
+		size_t msb = 0;
+		for (uint64_t rest = value >> 1; rest != 0; rest >>= 1)
+			msb++;
+#endif
+		return (msb - subBucketsLog2 + 1) * subBuckets +
+			static_cast<size_t>((value >> (msb - subBucketsLog2)) & (subBuckets - 1));
+	}
+
+	/**
+	* @fn getBucketLowerBound
+	* Get the smallest value counted by a bucket.
+	* @param size_t bucket: the bucket index
+	* @return uint64_t: the smallest value of the bucket
+	*/
+	static uint64_t getBucketLowerBound(size_t bucket)
+	{
+		if (bucket < subBuckets)
+			return bucket;
+		size_t shift = bucket / subBuckets - 1;
+		return static_cast<uint64_t>(subBuckets + bucket % subBuckets) << shift;
+	}
+
+	/**
+	* @fn getBucketUpperBound
+	* Get the largest value counted by a bucket.
+	* @param size_t bucket: the bucket index
+	* @return uint64_t: the largest value of the bucket
+	*/
+	static uint64_t getBucketUpperBound(size_t bucket)
+	{
+		if (bucket + 1 == bucketCount)
+			return UINT64_MAX;
+		return getBucketLowerBound(bucket + 1) - 1;
+	}
+
+private:
+	std::array<uint64_t, bucketCount> m_buckets{};
+	uint64_t m_count = 0;
+	uint64_t m_sum = 0;
+	uint64_t m_max = 0;
+};
+
+/**
+* @struct StageMetrics
+* Metrics of a stage, for a given module.
+*/
+struct StageMetrics
+{
+	Stage stage;
+	std::string module; ///< Module path, as in conf. Ex: `"mod/php"`. Empty for core-only stages
+	Histogram latency; ///< Time spent in the stage, in nanoseconds
+	uint64_t errors; ///< Failed calls: exceptions thrown, parse errors, failed writes
+};
+
+/**
+* @struct Gauge
+* Instant value. Ex: `"shard.0.pending_requests"`, `"log.queue_depth"`.
+*/
+struct Gauge
+{
+	std::string name;
+	int64_t value;
+};
+
+/**
+* @struct Snapshot
+* Server metrics at a given time. Counters are cumulative since server start:
+* sinks compute rates from consecutive snapshots.
+*/
+struct Snapshot
+{
+	std::chrono::system_clock::time_point timestamp;
+	uint64_t connections; ///< Accepted client connections
+	uint64_t requests; ///< Emitted requests
+	uint64_t bytesIn; ///< Bytes read from clients
+	uint64_t bytesOut; ///< Bytes written to clients
+	Histogram connectionBytesIn; ///< Bytes read per closed connection
+	Histogram connectionBytesOut; ///< Bytes written per closed connection
+	std::vector<StageMetrics> stages; ///< One per stage and module, handlers in conf-order
+	std::vector<Gauge> gauges; ///< Queue depths and other instant values
 };
 
+}
+
 #if _MSC_VER && !__INTEL_COMPILER
 #define ZIA_EXPORT_SYMBOL __declspec(dllexport)
 #else
@@ -632,6 +2245,19 @@ public:
 */
 namespace Module {
 
+/**
+* @enum Threading
+* How the server may use module instances across its threads.
+* The server runs one reactor thread per shard, each with its own listening socket (`SO_REUSEPORT`).
+* A client connection, its parser instance, requests, responses and contexts all stay on a single shard.
+*/
+enum class Threading
+{
+	PerShard, ///< The module is created once per shard, and each instance is only ever called from its shard thread
+	Shared ///< The module is created once, and its instance may be called concurrently from any shard thread
+};
+using FN_getModuleThreading = Zia::Module::Threading (void);
+
 using ILogger = Zia::ILogger;
 using FN_createLogger = Zia::Module::ILogger* (Zia::IConf &conf);
 
@@ -651,6 +2277,9 @@ public:
 	* @param IConnection &connection: the base connection
 	* @return std::unique_ptr<IConnection>: the derived connection
 	* @note Return value must be destroyed before connection.
+	* A TLS wrapper should, when possible, hand the session keys to the kernel once the handshake is done
+	* (Linux kTLS) and report it through `IConnection::isNativeSocketPlaintext`, so that the server
+	* can keep its zero-copy fast paths for encrypted traffic.
 	*/
 	virtual std::unique_ptr<IConnection> create(IConnection &connection) = 0;
 };
@@ -667,6 +2296,17 @@ class IParser
 public:
 	virtual ~IParser(void) = default;
 
+	/**
+	* @enum Phase
+	* Where a parser instance stands in the request it receives. The server picks the client timeout from it.
+	*/
+	enum class Phase
+	{
+		Idle, ///< Between requests, no byte of the next one received: `idle` timeout
+		Head, ///< Receiving a request line or headers: `header` timeout, armed once for the whole head
+		Body ///< Receiving a request body: `body` timeout, re-armed on each received byte, suspended while `Paused`
+	};
+
 	/**
 	* @interface IInstance
 	* Parser instance, storing parser state and stream / logger / request emitter.
@@ -682,6 +2322,47 @@ public:
 		* @note The stream / logger / request emitter are implicitely referenced on construction.
 		*/
 		virtual void parse(void) = 0;
+
+		/**
+		* @fn getReadiness
+		* Get what the parser waits for before `parse` can make progress.
+		* Queried by the server after each `parse` call. A parser that consumed all available bytes
+		* returns `NeedInput`: `parse` will be called again once the default connection has bytes available.
+		* `Ready` means the parser stopped early and should be called again right away.
+		* @return Readiness: the awaited event
+		* @note Default implementation returns `Ready`, which makes the server call `parse` regularly.
+		*/
+		virtual Readiness getReadiness(void) const
+		{
+			return Readiness::Ready;
+		}
+
+		/**
+		* @fn getPhase
+		* Get where the instance stands in the request it receives.
+		* Queried by the server along with `getReadiness`, to arm the matching client timeout.
+		* While the instance is `Paused`, the client is not read because a handler applies backpressure:
+		* the `body` timer is suspended then, and re-armed once parsing resumes.
+		* @return Phase: the current phase
+		* @note Default implementation returns `Idle`: a single timeout then applies to the whole connection.
+		*/
+		virtual Phase getPhase(void) const
+		{
+			return Phase::Idle;
+		}
+
+		/**
+		* @fn hibernate
+		* Release the memory held for a client that went idle.
+		* Called by the server once the instance has been `Idle` for a while on a kept-alive connection.
+		* The instance must keep working afterwards: buffers are allocated again by the next `parse` call.
+		* @return bool: true if memory was released
+		* @note Default implementation releases nothing and returns false.
+		*/
+		virtual bool hibernate(void)
+		{
+			return false;
+		}
 	};
 
 	/**
@@ -696,6 +2377,47 @@ public:
 };
 using FN_createParser = Zia::Module::IParser* (Zia::IConf &conf);
 
+/**
+* @struct HandlerFilter
+* Static predicate on the requests a handler is interested in. Each non-empty list must have a match.
+* The server queries it once, right after the handler creation, and compiles the configured handlers
+* into per-method and per-path dispatch tables: handlers not matching a request are never called for it.
+*/
+struct HandlerFilter
+{
+	std::vector<std::string> methods; ///< Methods handled, ex: `{"GET", "HEAD"}`. Empty for any method
+	std::vector<std::string> pathPrefixes; ///< Prefixes of the request filename, ex: `{"/api/"}`. Empty for any path
+	std::vector<std::string> extensions; ///< Extensions of the request filename, without dot, case insensitive, ex: `{"php"}`. Empty for any extension
+
+	/**
+	* @fn matches
+	* Check a request against the filter.
+	* @param const IRequest &req: the request
+	* @return bool: true if the handler is interested in the request
+	*/
+	bool matches(const IRequest &req) const
+	{
+		const std::string &filename = req.getFilename();
+
+		if (!methods.empty() && std::find(methods.begin(), methods.end(), req.getMethod()) == methods.end())
+			return false;
+		if (!pathPrefixes.empty() && std::none_of(pathPrefixes.begin(), pathPrefixes.end(),
+			[&filename](const std::string &prefix) {
+				return filename.compare(0, prefix.size(), prefix) == 0;
+			}))
+			return false;
+		if (extensions.empty())
+			return true;
+		size_t dot = filename.rfind('.');
+		if (dot == std::string::npos || filename.find('/', dot) != std::string::npos)
+			return false;
+		std::string_view extension = std::string_view(filename).substr(dot + 1);
+		return std::any_of(extensions.begin(), extensions.end(), [extension](const std::string &candidate) {
+			return equalsIgnoreCase(candidate, extension);
+		});
+	}
+};
+
 /**
 * @interface IResponse
 * Abstract HTTP handler.
@@ -712,11 +2434,111 @@ public:
 	* @param IResponse &res: the under-construction response
 	* @param IContext &ctx: the request-associated context
 	* @param ILogger &log: the client-associated logger
+	* @note Only called by the default implementation of `handleAsync`.
 	*/
 	virtual void handle(const IRequest &req, IResponse &res, IContext &ctx, ILogger &log) = 0;
+
+	/**
+	* @interface ICompletion
+	* Notifies the server that an asynchronous handling is over.
+	*/
+	class ICompletion
+	{
+	public:
+		virtual ~ICompletion(void) = default;
+
+		/**
+		* @fn complete
+		* Mark the handling as done. The server then resumes the pipeline at the next handler,
+		* unless abortPipeline was called on the response.
+		* @note Must be called exactly once. It can be called from any thread,
+		* the pipeline is always resumed on the shard of the request.
+		*/
+		virtual void complete(void) = 0;
+	};
+
+	/**
+	* @fn handleAsync
+	* Handle request, possibly asynchronously. The handler may return before it is done with the request,
+	* and call complete on completion later (e.g. when a CGI process or an upstream answered).
+	* In the meantime, the request is suspended and the server keeps serving other connections.
+	* @param const IRequest &req: the original request
+	* @param IResponse &res: the under-construction response
+	* @param IContext &ctx: the request-associated context
+	* @param ILogger &log: the client-associated logger
+	* @param ICompletion &completion: the object to notify once handling is over
+	* @note req, res, ctx, log and completion remain valid until completion is notified.
+	* A coroutine-based handler typically notifies completion from its final suspension point.
+	* Default implementation calls `handle` and notifies completion right away.
+	*/
+	virtual void handleAsync(const IRequest &req, IResponse &res, IContext &ctx, ILogger &log, ICompletion &completion)
+	{
+		handle(req, res, ctx, log);
+		completion.complete();
+	}
+
+	/**
+	* @fn finalize
+	* Called once the pipeline is over, before the response is written to the client.
+	* Handlers are finalized in reverse order, and only those that were called for the request are.
+	* Typically used to observe or post-process the final response (e.g. storing it in a cache).
+	* @param const IRequest &req: the original request
+	* @param IResponse &res: the final response
+	* @param IContext &ctx: the request-associated context
+	* @param ILogger &log: the client-associated logger
+	* @note Default implementation does nothing.
+	*/
+	virtual void finalize(const IRequest &req, IResponse &res, IContext &ctx, ILogger &log)
+	{
+		static_cast<void>(req);
+		static_cast<void>(res);
+		static_cast<void>(ctx);
+		static_cast<void>(log);
+	}
+
+	/**
+	* @fn getFilter
+	* Declare which requests the handler is interested in. Only called once, right after creation.
+	* @return HandlerFilter: the static request filter of the handler
+	* @note Default implementation matches every request.
+	*/
+	virtual HandlerFilter getFilter(void) const
+	{
+		return HandlerFilter();
+	}
 };
 using FN_createHandler = Zia::Module::IHandler* (Zia::IConf &conf);
 
+/**
+* @interface IMetricsSink
+* Consumer of server metrics, ex: an exporter serving a scrape endpoint, or writing a dump file.
+*/
+class IMetricsSink
+{
+public:
+	virtual ~IMetricsSink(void) = default;
+
+	/**
+	* @fn consume
+	* Receive a metrics snapshot. Called periodically from a background thread, never concurrently
+	* for a given sink: a slow sink never delays requests.
+	* @param const Metrics::Snapshot &snapshot: the server metrics
+	*/
+	virtual void consume(const Metrics::Snapshot &snapshot) = 0;
+
+	/**
+	* @fn getInterval
+	* Get the interval at which the sink wants snapshots. Only called once, right after creation.
+	* @return std::chrono::milliseconds: the interval between two calls to `consume`
+	* @note Default implementation returns 10 seconds.
+	*/
+	virtual std::chrono::milliseconds getInterval(void) const
+	{
+		return std::chrono::seconds(10);
+	}
+};
+using FN_createMetricsSink = Zia::Module::IMetricsSink* (Zia::IConf &conf);
+
 }
 
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Zia.hpp"
+#include "Threading.hpp"
 
 /** @file
  * Include that in your Zia::Module::IParser implementation.
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../Zia.hpp"
+
+/** @file
+ * Included by every module kind header.
+ * Optionally implement getModuleThreading in your module shared lib to tell the server
+ * how it may share module instances between its threads.
+*/
+
+extern "C" {
+
+/**
+* @fn getModuleThreading
+* Query how the server may use the module instances across its shards.
+* @return Zia::Module::Threading: the threading model supported by the module
+* @note This symbol is optional. When it is absent from the shared lib, the server assumes
+* Zia::Module::Threading::PerShard, which is always safe.
+*/
+ZIA_EXPORT_SYMBOL Zia::Module::Threading getModuleThreading(void);
+
+}
\ No newline at end of file
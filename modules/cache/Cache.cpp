@@ -0,0 +1,307 @@
+#include "Cache.hpp"
+#include "TeeSource.hpp"
+
+#include "zia/module/Handler.hpp"
+
+namespace Zia::ResponseCache {
+
+namespace {
+
+/**
+* @struct CacheControl
+* Cache-Control directives relevant to a shared cache.
+*/
+struct CacheControl
+{
+	bool noStore = false;
+	bool noCache = false;
+	bool isPrivate = false;
+	std::optional<size_t> maxAge;
+	std::optional<size_t> sMaxAge;
+};
+
+std::string_view trim(std::string_view str)
+{
+	while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+		str.remove_prefix(1);
+	while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+		str.remove_suffix(1);
+	return str;
+}
+
+// Calls fn on each trimmed, non-empty element of a comma-separated list
+template <typename Fn>
+void forEachElement(std::string_view list, Fn &&fn)
+{
+	while (!list.empty()) {
+		size_t comma = list.find(',');
+		std::string_view element = trim(list.substr(0, comma));
+
+		if (!element.empty())
+			fn(element);
+		list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+	}
+}
+
+std::optional<size_t> parseSeconds(std::string_view str)
+{
+	size_t res = 0;
+
+	if (str.size() >= 2 && str.front() == '"' && str.back() == '"')
+		str = str.substr(1, str.size() - 2);
+	if (str.empty())
+		return std::nullopt;
+	for (char c : str) {
+		if (c < '0' || c > '9')
+			return std::nullopt;
+		// Saturate, as recommended for delta-seconds
+		res = res > (size_t(1) << 31) ? res : res * 10 + (c - '0');
+	}
+	return res;
+}
+
+CacheControl parseCacheControl(std::string_view value)
+{
+	CacheControl res;
+
+	forEachElement(value, [&res](std::string_view directive) {
+		size_t equal = directive.find('=');
+		std::string_view name = trim(directive.substr(0, equal));
+		std::string_view argument = equal == std::string_view::npos ? std::string_view() : trim(directive.substr(equal + 1));
+
+		if (equalsIgnoreCase(name, "no-store"))
+			res.noStore = true;
+		else if (equalsIgnoreCase(name, "no-cache"))
+			res.noCache = true;
+		else if (equalsIgnoreCase(name, "private"))
+			res.isPrivate = true;
+		else if (equalsIgnoreCase(name, "max-age"))
+			res.maxAge = parseSeconds(argument);
+		else if (equalsIgnoreCase(name, "s-maxage"))
+			res.sMaxAge = parseSeconds(argument);
+	});
+	return res;
+}
+
+std::string_view stripWeak(std::string_view etag)
+{
+	if (etag.size() >= 2 && etag.substr(0, 2) == "W/")
+		etag.remove_prefix(2);
+	return etag;
+}
+
+bool matchesETag(std::string_view ifNoneMatch, std::string_view etag)
+{
+	bool res = false;
+
+	// Weak comparison, as mandated for If-None-Match
+	forEachElement(ifNoneMatch, [&res, etag](std::string_view candidate) {
+		if (candidate == "*" || stripWeak(candidate) == stripWeak(etag))
+			res = true;
+	});
+	return res;
+}
+
+bool isCacheableCode(size_t code)
+{
+	// Heuristically cacheable status codes that this module stores
+	return code == 200 || code == 203 || code == 204 || code == 300 || code == 301 || code == 404 || code == 410;
+}
+
+// Headers that describe the connection or the transfer, not the stored representation
+bool isStoredHeader(std::string_view key)
+{
+	std::optional<HeaderId> id = findHeaderId(key);
+
+	return !id || (*id != HeaderId::Connection && *id != HeaderId::KeepAlive &&
+		*id != HeaderId::TransferEncoding && *id != HeaderId::ContentLength &&
+		*id != HeaderId::Date && *id != HeaderId::Age);
+}
+
+/**
+* @class HeaderCollector
+* Every header of a response: its parameters, then the ones of its header blocks, which `getHeader` does not see.
+*/
+class HeaderCollector : public IRequest::IFieldVisitor
+{
+public:
+	explicit HeaderCollector(const IResponse &res)
+	{
+		res.visitHeaders(*this);
+		for (const SharedBuffer &block : res.getHeaderBlocks())
+			for (auto &header : parseHeaderBlock(*block))
+				headers.push_back(std::move(header));
+	}
+
+	void visit(std::string_view key, std::string_view value) override
+	{
+		headers.emplace_back(std::string(key), std::string(value));
+	}
+
+	const std::string* find(HeaderId id) const
+	{
+		for (const auto &header : headers)
+			if (findHeaderId(header.first) == id)
+				return &header.second;
+		return nullptr;
+	}
+
+	std::vector<std::pair<std::string, std::string>> getStored(void) const
+	{
+		std::vector<std::pair<std::string, std::string>> res;
+
+		for (const auto &header : headers)
+			if (isStoredHeader(header.first))
+				res.push_back(header);
+		return res;
+	}
+
+	std::vector<std::pair<std::string, std::string>> headers;
+};
+
+}
+
+Cache::Cache(IConf &conf) :
+	m_pendingKey("cache.pending")
+{
+	std::shared_ptr<const Json::IObject> obj = conf.snapshot();
+
+	if (std::optional<Json::Integer> size = obj->getInteger("max_size"); size && *size >= 0)
+		m_config.maxSize = static_cast<size_t>(*size);
+	if (std::optional<Json::Integer> size = obj->getInteger("max_entry_size"); size && *size >= 0)
+		m_config.maxEntrySize = static_cast<size_t>(*size);
+	if (std::optional<Json::Integer> ttl = obj->getInteger("default_ttl"); ttl && *ttl >= 0)
+		m_config.defaultTtl = static_cast<size_t>(*ttl);
+	m_store = std::make_shared<Store>(m_config.maxSize);
+}
+
+void Cache::handle(const IRequest &req, IResponse &res, IContext &ctx, ILogger &log)
+{
+	static_cast<void>(log);
+	const std::string &method = req.getMethod();
+
+	if (method != "GET" && method != "HEAD")
+		return;
+	// Responses to authenticated requests are private to the user
+	if (req.findHeader(HeaderId::Authorization))
+		return;
+	CacheControl control = parseCacheControl(req.findHeader(HeaderId::CacheControl).value_or(""));
+	if (control.noStore)
+		return;
+
+	// Content negotiation on encoding is the only variance supported, see finalize
+	std::string key(req.findHeader(HeaderId::Host).value_or(""));
+	key += req.getURL();
+	key += '\n';
+	key += req.findHeader(HeaderId::AcceptEncoding).value_or("");
+
+	bool revalidate = control.noCache || req.findHeader(HeaderId::Pragma).value_or("") == "no-cache";
+	if (!revalidate) {
+		if (std::shared_ptr<const Entry> entry = m_store->find(key)) {
+			serve(req, res, *entry);
+			return;
+		}
+	}
+	// HEAD responses carry no body to store
+	if (method == "GET")
+		ctx.emplace(m_pendingKey, std::move(key));
+}
+
+void Cache::finalize(const IRequest &req, IResponse &res, IContext &ctx, ILogger &log)
+{
+	static_cast<void>(req);
+	static_cast<void>(log);
+	std::string *key = ctx.get(m_pendingKey);
+
+	if (key == nullptr || !isCacheableCode(res.getCode()))
+		return;
+	// Header blocks are stored along with the parameters, and may carry any of the headers checked here
+	HeaderCollector collector(res);
+	if (collector.find(HeaderId::SetCookie))
+		return;
+	CacheControl control;
+	if (const std::string *value = collector.find(HeaderId::CacheControl))
+		control = parseCacheControl(*value);
+	if (control.noStore || control.noCache || control.isPrivate)
+		return;
+	if (const std::string *vary = collector.find(HeaderId::Vary); vary && !equalsIgnoreCase(trim(*vary), "Accept-Encoding"))
+		return;
+	size_t ttl = control.sMaxAge.value_or(control.maxAge.value_or(m_config.defaultTtl));
+	if (ttl == 0)
+		return;
+
+	auto entry = std::make_shared<Entry>();
+	entry->code = res.getCode();
+	entry->headers = makeHeaderBlock(collector.getStored());
+	if (const std::string *etag = collector.find(HeaderId::ETag))
+		entry->etag = *etag;
+	entry->storedAt = Clock::now();
+	entry->expiresAt = entry->storedAt + std::chrono::seconds(ttl);
+
+	if (const std::vector<char> *body = res.getBody()) {
+		if (body->size() > m_config.maxEntrySize)
+			return;
+		// Moved into a shared buffer, which the response then writes
+		SharedBuffer shared = std::make_shared<const std::vector<char>>(res.takeBody());
+		res.setBody(shared);
+		entry->body = std::move(shared);
+		m_store->insert(*key, std::move(entry));
+		return;
+	}
+	std::unique_ptr<IBodySource> source = res.takeBodySource();
+	if (!source) {
+		entry->body = std::make_shared<const std::vector<char>>();
+		m_store->insert(*key, std::move(entry));
+		return;
+	}
+	if (std::optional<size_t> size = source->getSize(); size && *size > m_config.maxEntrySize) {
+		res.setBodySource(std::move(source));
+		return;
+	}
+	// Streamed bodies are captured while the server writes them, and stored once complete
+	res.setBodySource(std::make_unique<TeeSource>(std::move(source), m_store, std::move(*key),
+		std::move(entry), m_config.maxEntrySize));
+}
+
+Module::HandlerFilter Cache::getFilter(void) const
+{
+	Module::HandlerFilter res;
+
+	res.methods = {"GET", "HEAD"};
+	return res;
+}
+
+void Cache::serve(const IRequest &req, IResponse &res, const Entry &entry) const
+{
+	auto age = std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - entry.storedAt);
+
+	res.abortPipeline();
+	if (std::optional<std::string_view> ifNoneMatch = req.findHeader(HeaderId::IfNoneMatch);
+		ifNoneMatch && !entry.etag.empty() && matchesETag(*ifNoneMatch, entry.etag)) {
+		res.setCode(304);
+		res.setHeader(HeaderId::ETag, entry.etag);
+		res.setHeader(HeaderId::Age, std::to_string(age.count()));
+		return;
+	}
+	res.setCode(entry.code);
+	res.addHeaderBlock(entry.headers);
+	res.setHeader(HeaderId::Age, std::to_string(age.count()));
+	res.setBody(entry.body);
+}
+
+}
+
+extern "C" {
+
+ZIA_EXPORT_SYMBOL Zia::Module::IHandler* createHandler(Zia::IConf &conf)
+{
+	return new Zia::ResponseCache::Cache(conf);
+}
+
+ZIA_EXPORT_SYMBOL Zia::Module::Threading getModuleThreading(void)
+{
+	// A single store serves all shards, so that a response is cached once
+	return Zia::Module::Threading::Shared;
+}
+
+}
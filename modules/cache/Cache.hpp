@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Store.hpp"
+
+namespace Zia::ResponseCache {
+
+/**
+* @struct Config
+* Cache module configuration.
+*/
+struct Config
+{
+	size_t maxSize = 64 * 1024 * 1024; ///< Memory budget of the whole cache
+	size_t maxEntrySize = 8 * 1024 * 1024; ///< Larger bodies are not stored
+	size_t defaultTtl = 0; ///< Lifetime of responses without max-age, in seconds. 0 to not store them
+};
+
+/**
+* @class Cache
+* Reference HTTP response cache handler module.
+* Fresh responses to GET and HEAD requests are answered from memory and end the pipeline.
+* On a miss, the final response is stored from `finalize` if it is cacheable.
+* Cached bodies are shared, immutable buffers: serving a hit copies no body byte.
+* Configuration keys: `"max_size"` and `"max_entry_size"` in bytes, `"default_ttl"` in seconds.
+*/
+class Cache : public Module::IHandler
+{
+public:
+	/**
+	* @fn Cache
+	* Create the module.
+	* @param IConf &conf: module configuration
+	*/
+	explicit Cache(IConf &conf);
+	~Cache(void) override = default;
+
+	void handle(const IRequest &req, IResponse &res, IContext &ctx, ILogger &log) override;
+	void finalize(const IRequest &req, IResponse &res, IContext &ctx, ILogger &log) override;
+	Module::HandlerFilter getFilter(void) const override;
+
+private:
+	Config m_config;
+	std::shared_ptr<Store> m_store;
+	ContextKey<std::string> m_pendingKey; ///< Key of a missed response, to store once final
+
+	void serve(const IRequest &req, IResponse &res, const Entry &entry) const;
+};
+
+}
@@ -0,0 +1,123 @@
+#include "Store.hpp"
+
+#include <algorithm>
+
+namespace Zia::ResponseCache {
+
+namespace {
+
+// Bookkeeping cost of an entry, on top of its key, headers and body
+constexpr size_t entryOverhead = 256;
+
+size_t getCost(const std::string &key, const Entry &entry)
+{
+	return entryOverhead + key.size() + entry.etag.size() + (entry.headers ? entry.headers->size() : 0) +
+		(entry.body ? entry.body->size() : 0);
+}
+
+}
+
+FrequencySketch::FrequencySketch(void) :
+	m_counters(depth << widthLog2),
+	m_additions(0)
+{
+}
+
+void FrequencySketch::increment(size_t hash)
+{
+	for (size_t row = 0; row < depth; row++) {
+		uint8_t &counter = m_counters[index(hash, row)];
+		if (counter < 15)
+			counter++;
+	}
+	// Aging: halve all counters periodically, so that past popularity fades
+	if (++m_additions == (size_t(10) << widthLog2)) {
+		for (uint8_t &counter : m_counters)
+			counter >>= 1;
+		m_additions /= 2;
+	}
+}
+
+uint8_t FrequencySketch::estimate(size_t hash) const
+{
+	uint8_t res = 15;
+
+	for (size_t row = 0; row < depth; row++)
+		res = std::min(res, m_counters[index(hash, row)]);
+	return res;
+}
+
+size_t FrequencySketch::index(size_t hash, size_t row) const
+{
+	static constexpr uint64_t seeds[depth] = {
+		0x9e3779b97f4a7c15, 0xc2b2ae3d27d4eb4f, 0x165667b19e3779f9, 0x27d4eb2f165667c5
+	};
+	uint64_t mixed = (static_cast<uint64_t>(hash) + row) * seeds[row];
+
+	return (row << widthLog2) + static_cast<size_t>(mixed >> (64 - widthLog2));
+}
+
+Store::Store(size_t capacity) :
+	m_capacity(capacity),
+	m_size(0)
+{
+}
+
+std::shared_ptr<const Entry> Store::find(const std::string &key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_sketch.increment(std::hash<std::string>()(key));
+	auto found = m_index.find(key);
+	if (found == m_index.end())
+		return nullptr;
+	if (Clock::now() >= found->second->entry->expiresAt) {
+		erase(found->second);
+		return nullptr;
+	}
+	m_lru.splice(m_lru.begin(), m_lru, found->second);
+	return found->second->entry;
+}
+
+void Store::insert(const std::string &key, std::shared_ptr<const Entry> entry)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t cost = getCost(key, *entry);
+
+	if (cost > m_capacity)
+		return;
+	auto found = m_index.find(key);
+	std::optional<std::list<Node>::iterator> previous;
+	if (found != m_index.end())
+		previous = found->second;
+	// Victims are only chosen here: nothing is evicted or replaced unless the entry is admitted
+	size_t size = m_size - (previous ? (*previous)->cost : 0);
+	uint8_t frequency = m_sketch.estimate(std::hash<std::string>()(key));
+	std::vector<std::list<Node>::iterator> victims;
+	for (auto victim = m_lru.end(); size + cost > m_capacity;) {
+		victim--;
+		if (previous && victim == *previous)
+			continue;
+		if (Clock::now() < victim->entry->expiresAt &&
+			m_sketch.estimate(std::hash<std::string>()(victim->key)) >= frequency)
+			return;
+		size -= victim->cost;
+		victims.push_back(victim);
+	}
+	for (auto victim : victims)
+		erase(victim);
+	if (previous)
+		erase(*previous);
+	m_lru.push_front(Node{key, std::move(entry), cost});
+	m_index.emplace(key, m_lru.begin());
+	m_size += cost;
+}
+
+void Store::erase(std::list<Node>::iterator node)
+{
+	m_size -= node->cost;
+	m_index.erase(node->key);
+	m_lru.erase(node);
+}
+
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "zia/Zia.hpp"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+/**
+* @namespace Zia::ResponseCache
+* Reference HTTP response cache handler module.
+*/
+namespace Zia::ResponseCache {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+* @struct Entry
+* Cached response. Immutable once stored, shared by all the responses it is served to.
+*/
+struct Entry
+{
+	size_t code;
+	SharedBuffer headers; ///< Serialized once, see makeHeaderBlock
+	SharedBuffer body;
+	std::string etag;
+	Clock::time_point storedAt;
+	Clock::time_point expiresAt;
+};
+
+/**
+* @class FrequencySketch
+* Approximate access frequency of keys (count-min sketch of 4-bit counters), aged periodically.
+* Used as TinyLFU admission filter: a new entry only evicts entries that are less popular.
+*/
+class FrequencySketch
+{
+public:
+	FrequencySketch(void);
+
+	/**
+	* @fn increment
+	* Record an access to a key.
+	* @param size_t hash: the hash of the key
+	*/
+	void increment(size_t hash);
+
+	/**
+	* @fn estimate
+	* Estimate the access frequency of a key.
+	* @param size_t hash: the hash of the key
+	* @return uint8_t: the estimated frequency, at most 15
+	*/
+	uint8_t estimate(size_t hash) const;
+
+private:
+	static constexpr size_t depth = 4;
+	static constexpr size_t widthLog2 = 16;
+
+	std::vector<uint8_t> m_counters;
+	size_t m_additions;
+
+	size_t index(size_t hash, size_t row) const;
+};
+
+/**
+* @class Store
+* Thread-safe response store with a bounded memory budget.
+* Entries are evicted in least recently used order, with TinyLFU admission.
+*/
+class Store
+{
+public:
+	/**
+	* @fn Store
+	* Create a store.
+	* @param size_t capacity: memory budget of the store, in bytes
+	*/
+	explicit Store(size_t capacity);
+
+	/**
+	* @fn find
+	* Find a fresh entry, and record the access. Expired entries are removed.
+	* @param const std::string &key: the key of the entry
+	* @return std::shared_ptr<const Entry>: the entry, nullptr if not found or expired
+	*/
+	std::shared_ptr<const Entry> find(const std::string &key);
+
+	/**
+	* @fn insert
+	* Insert an entry, if the admission policy accepts it: the entry must be more frequently requested than
+	* every fresh entry it would evict. A rejected entry leaves the store untouched, including any entry for its key.
+	* @param const std::string &key: the key of the entry
+	* @param std::shared_ptr<const Entry> entry: the entry
+	*/
+	void insert(const std::string &key, std::shared_ptr<const Entry> entry);
+
+private:
+	struct Node
+	{
+		std::string key;
+		std::shared_ptr<const Entry> entry;
+		size_t cost;
+	};
+
+	std::mutex m_mutex;
+	size_t m_capacity;
+	size_t m_size;
+	std::list<Node> m_lru; ///< Most recently used first
+	std::unordered_map<std::string, std::list<Node>::iterator> m_index;
+	FrequencySketch m_sketch;
+
+	void erase(std::list<Node>::iterator node);
+};
+
+}
@@ -0,0 +1,73 @@
+#include "TeeSource.hpp"
+
+namespace Zia::ResponseCache {
+
+TeeSource::TeeSource(std::unique_ptr<IBodySource> source, std::shared_ptr<Store> store, std::string key,
+	std::shared_ptr<Entry> entry, size_t maxSize) :
+	m_source(std::move(source)),
+	m_store(std::move(store)),
+	m_key(std::move(key)),
+	m_entry(std::move(entry)),
+	m_maxSize(maxSize)
+{
+	if (std::optional<size_t> size = m_source->getSize())
+		m_captured.reserve(*size);
+}
+
+TeeSource::~TeeSource(void)
+{
+	// The server may stop pulling as soon as isOver is true, without a last read
+	if (m_entry && m_source->isOver())
+		store();
+}
+
+size_t TeeSource::read(size_t buf_size, char *buf)
+{
+	size_t res = m_source->read(buf_size, buf);
+
+	if (!m_entry)
+		return res;
+	if (m_captured.size() + res > m_maxSize) {
+		m_entry.reset();
+		m_captured = std::vector<char>();
+		return res;
+	}
+	m_captured.insert(m_captured.end(), buf, buf + res);
+	if (m_source->isOver())
+		store();
+	return res;
+}
+
+std::optional<size_t> TeeSource::getSize(void) const
+{
+	return m_source->getSize();
+}
+
+bool TeeSource::isOver(void) const
+{
+	return m_source->isOver();
+}
+
+bool TeeSource::isAborted(void) const
+{
+	return m_source->isAborted();
+}
+
+void TeeSource::setListener(IListener *listener)
+{
+	m_source->setListener(listener);
+}
+
+void TeeSource::store(void)
+{
+	// A truncated body is never served
+	if (m_source->isAborted()) {
+		m_entry.reset();
+		return;
+	}
+	m_entry->body = std::make_shared<const std::vector<char>>(std::move(m_captured));
+	m_store->insert(m_key, std::move(m_entry));
+	m_entry.reset();
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Store.hpp"
+
+namespace Zia::ResponseCache {
+
+/**
+* @class TeeSource
+* Body source forwarding an upstream source, while keeping a copy of the bytes read.
+* The response is stored once the upstream source is over, if its body is complete and did not exceed the size limit.
+*/
+class TeeSource : public IBodySource
+{
+public:
+	/**
+	* @fn TeeSource
+	* Wrap a body source.
+	* @param std::unique_ptr<IBodySource> source: the upstream source
+	* @param std::shared_ptr<Store> store: the store where the response goes
+	* @param std::string key: the key of the response
+	* @param std::shared_ptr<Entry> entry: the response, without its body
+	* @param size_t maxSize: the maximum body size, capture is abandoned past it
+	*/
+	TeeSource(std::unique_ptr<IBodySource> source, std::shared_ptr<Store> store, std::string key,
+		std::shared_ptr<Entry> entry, size_t maxSize);
+	~TeeSource(void) override;
+
+	size_t read(size_t buf_size, char *buf) override;
+	std::optional<size_t> getSize(void) const override;
+	bool isOver(void) const override;
+	bool isAborted(void) const override;
+	void setListener(IListener *listener) override;
+
+private:
+	std::unique_ptr<IBodySource> m_source;
+	std::shared_ptr<Store> m_store;
+	std::string m_key;
+	std::shared_ptr<Entry> m_entry; ///< nullptr once stored or abandoned
+	std::vector<char> m_captured;
+	size_t m_maxSize;
+
+	void store(void);
+};
+
+}
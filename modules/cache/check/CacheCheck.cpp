@@ -0,0 +1,339 @@
+#include "../Cache.hpp"
+
+#include "Exchange.hpp"
+#include "Json.hpp"
+#include "Support.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+/** @file
+ * Regression checks of the reference cache: admission and expiry of the store, then requests passed
+ * through the handler, the handlers after it answering on a miss.
+ * Usage: `cache_check`, returns non-zero if a check fails. Also run by `ctest`.
+*/
+
+namespace {
+
+using namespace Zia;
+using namespace Zia::Support;
+
+using Headers = std::vector<std::pair<std::string, std::string>>;
+
+/**
+* @struct Origin
+* Response of the handlers after the cache.
+*/
+struct Origin
+{
+	size_t code;
+	Headers headers;
+	std::string body;
+	bool streamed = false; ///< Body written through a source instead of a buffer
+	bool truncated = false; ///< The streamed body ends aborted
+	Headers block = {}; ///< Attached as a header block
+};
+
+/**
+* @class StringSource
+* Body source of unknown size, reading a string by small chunks.
+*/
+class StringSource : public IBodySource
+{
+public:
+	StringSource(std::string data, bool aborted) :
+		m_data(std::move(data)),
+		m_pos(0),
+		m_aborted(aborted)
+	{
+	}
+
+	size_t read(size_t buf_size, char *buf) override
+	{
+		size_t res = std::min({buf_size, m_data.size() - m_pos, size_t(4)});
+
+		m_data.copy(buf, res, m_pos);
+		m_pos += res;
+		return res;
+	}
+
+	std::optional<size_t> getSize(void) const override
+	{
+		return std::nullopt;
+	}
+
+	bool isOver(void) const override
+	{
+		return m_pos == m_data.size();
+	}
+
+	bool isAborted(void) const override
+	{
+		return m_aborted && isOver();
+	}
+
+private:
+	std::string m_data;
+	size_t m_pos;
+	bool m_aborted;
+};
+
+size_t failures = 0;
+size_t checks = 0;
+
+void expect(bool condition, const char *name, const char *what)
+{
+	checks++;
+	if (condition)
+		return;
+	std::printf("FAIL %s: %s\n", name, what);
+	failures++;
+}
+
+std::string readAll(IBodySource &source)
+{
+	std::string res;
+	char buf[256];
+
+	while (size_t got = source.read(sizeof(buf), buf))
+		res.append(buf, got);
+	return res;
+}
+
+std::string getBody(Response &res)
+{
+	if (const std::vector<char> *body = res.getBody())
+		return std::string(body->begin(), body->end());
+	if (std::unique_ptr<IBodySource> source = res.takeBodySource())
+		return readAll(*source);
+	return "";
+}
+
+std::shared_ptr<const ResponseCache::Entry> makeEntry(size_t bodySize, ResponseCache::Clock::duration ttl)
+{
+	auto res = std::make_shared<ResponseCache::Entry>();
+
+	res->code = 200;
+	res->body = std::make_shared<const std::vector<char>>(bodySize, 'b');
+	res->storedAt = ResponseCache::Clock::now();
+	res->expiresAt = res->storedAt + ttl;
+	return res;
+}
+
+Request makeRequest(const Headers &headers)
+{
+	Request res("GET", "/page");
+
+	res.addHeader("Host", "example");
+	for (const auto &header : headers)
+		res.addHeader(header.first, header.second);
+	return res;
+}
+
+/**
+* @fn pass
+* Pass a request through the cache, as the server pipeline does. The streamed body of a miss is read
+* by the client before returning, which stores it.
+* @param ResponseCache::Cache &cache: the cache
+* @param const Request &req: the request
+* @param const Origin &origin: the response of the handlers after the cache, on a miss
+* @param Response &res: the response
+* @return bool: true if the cache answered
+*/
+bool pass(ResponseCache::Cache &cache, const Request &req, const Origin &origin, Response &res)
+{
+	NullLogger log;
+	// Context values are never deallocated one by one: the arena is released with the request
+	std::pmr::monotonic_buffer_resource arena;
+	Context ctx(arena);
+
+	cache.handle(req, res, ctx, log);
+	if (res.isAborted())
+		return true;
+	res.setCode(origin.code);
+	for (const auto &header : origin.headers)
+		res.setHeader(header.first, header.second);
+	if (!origin.block.empty())
+		res.addHeaderBlock(makeHeaderBlock(origin.block));
+	if (origin.streamed)
+		res.setBodySource(std::make_unique<StringSource>(origin.body, origin.truncated));
+	else
+		res.setBody(std::vector<char>(origin.body.begin(), origin.body.end()));
+	cache.finalize(req, res, ctx, log);
+	if (origin.streamed)
+		getBody(res);
+	return false;
+}
+
+/**
+* @fn isStored
+* Pass a request twice through a new cache.
+* @param const Origin &origin: the response of the handlers after the cache
+* @param const Headers &headers: the request headers, besides Host
+* @return bool: true if the second request was answered by the cache
+*/
+bool isStored(const Origin &origin, const Headers &headers = {})
+{
+	Conf conf;
+	ResponseCache::Cache cache(conf);
+	Request req = makeRequest(headers);
+	Response miss;
+	Response hit;
+
+	pass(cache, req, origin, miss);
+	return pass(cache, req, origin, hit);
+}
+
+void checkAdmission(void)
+{
+	const char *name = "rejected admission";
+	// Room for two empty entries with one-byte keys, not three
+	ResponseCache::Store store(600);
+	std::shared_ptr<const ResponseCache::Entry> a = makeEntry(0, std::chrono::minutes(1));
+	std::shared_ptr<const ResponseCache::Entry> b = makeEntry(0, std::chrono::minutes(1));
+
+	store.insert("a", a);
+	store.insert("b", b);
+	for (int i = 0; i < 3; i++)
+		store.find("a");
+	// "b" is the least recently used, and as popular as "c"
+	store.insert("c", makeEntry(0, std::chrono::minutes(1)));
+	// Replacing "b" by a larger entry needs to evict the more popular "a"
+	store.insert("b", makeEntry(200, std::chrono::minutes(1)));
+	expect(store.find("c") == nullptr, name, "new entry admitted over an as popular one");
+	expect(store.find("a") == a, name, "popular entry evicted");
+	expect(store.find("b") == b, name, "entry replaced or evicted by a rejected one");
+}
+
+void checkEviction(void)
+{
+	const char *name = "least recently used eviction";
+	ResponseCache::Store store(600);
+	std::shared_ptr<const ResponseCache::Entry> a = makeEntry(0, std::chrono::minutes(1));
+	std::shared_ptr<const ResponseCache::Entry> c = makeEntry(0, std::chrono::minutes(1));
+
+	store.insert("a", a);
+	store.insert("b", makeEntry(0, std::chrono::minutes(1)));
+	store.find("a");
+	for (int i = 0; i < 3; i++)
+		store.find("c");
+	store.insert("c", c);
+	expect(store.find("c") == c, name, "more popular entry not admitted");
+	expect(store.find("b") == nullptr, name, "least recently used entry kept");
+	expect(store.find("a") == a, name, "recently used entry evicted");
+}
+
+void checkExpiry(void)
+{
+	const char *name = "expiry";
+	ResponseCache::Store store(600);
+	std::shared_ptr<const ResponseCache::Entry> fresh = makeEntry(0, std::chrono::minutes(1));
+
+	store.insert("stale", makeEntry(0, -std::chrono::seconds(1)));
+	store.insert("fresh", fresh);
+	expect(store.find("stale") == nullptr, name, "expired entry found");
+	expect(store.find("fresh") == fresh, name, "fresh entry not found");
+
+	// Expired entries make room whatever their popularity
+	ResponseCache::Store full(600);
+	for (int i = 0; i < 3; i++)
+		full.find("old");
+	full.insert("old", makeEntry(0, -std::chrono::seconds(1)));
+	full.insert("fresh", fresh);
+	full.insert("new", makeEntry(0, std::chrono::minutes(1)));
+	expect(full.find("new") != nullptr, name, "expired entry not evicted");
+	expect(full.find("fresh") == fresh, name, "fresh entry evicted instead of an expired one");
+}
+
+void checkBypass(void)
+{
+	const Headers cacheable = {{"Cache-Control", "max-age=60"}};
+
+	expect(isStored({200, cacheable, "page"}), "fresh response", "not served from the cache");
+	expect(isStored({200, {{"Cache-Control", "public, max-age=60"}, {"Vary", "Accept-Encoding"}}, "page"}),
+		"Vary on Accept-Encoding", "not served from the cache");
+	expect(!isStored({200, {}, "page"}), "no lifetime", "stored");
+	expect(!isStored({200, {{"Cache-Control", "max-age=0"}}, "page"}), "max-age=0", "stored");
+	expect(!isStored({200, {{"Cache-Control", "no-store, max-age=60"}}, "page"}), "no-store response", "stored");
+	expect(!isStored({200, {{"Cache-Control", "private, max-age=60"}}, "page"}), "private response", "stored");
+	expect(!isStored({200, {{"Cache-Control", "max-age=60"}, {"Vary", "User-Agent"}}, "page"}), "Vary", "stored");
+	expect(!isStored({200, {{"Cache-Control", "max-age=60"}, {"Set-Cookie", "id=1"}}, "page"}), "Set-Cookie",
+		"stored");
+	expect(!isStored({500, cacheable, "error"}), "uncacheable status", "stored");
+	expect(!isStored({200, cacheable, "page"}, {{"Cache-Control", "no-store"}}), "no-store request", "stored");
+	expect(!isStored({200, cacheable, "page"}, {{"Authorization", "Basic YTpi"}}), "authorized request", "stored");
+	expect(isStored({200, cacheable, "streamed page", true}), "streamed body", "not served from the cache");
+	expect(!isStored({200, cacheable, "streamed page", true, true}), "truncated streamed body", "stored");
+}
+
+void checkHit(void)
+{
+	const char *name = "cache hit";
+	Conf conf;
+	ResponseCache::Cache cache(conf);
+	Origin origin{200, {{"Cache-Control", "max-age=60"}, {"ETag", "\"v1\""}}, "page"};
+	Response miss;
+	Response hit;
+
+	expect(!pass(cache, makeRequest({}), origin, miss), name, "first request answered by the cache");
+	expect(getBody(miss) == "page", name, "body of a miss altered");
+	expect(pass(cache, makeRequest({}), origin, hit), name, "not served from the cache");
+	expect(hit.getCode() == 200 && getBody(hit) == "page", name, "cached response altered");
+	expect(hit.getHeader(HeaderId::Age) != nullptr, name, "no Age header");
+
+	name = "conditional GET";
+	Response notModified;
+	expect(pass(cache, makeRequest({{"If-None-Match", "\"v0\", W/\"v1\""}}), origin, notModified), name,
+		"not served from the cache");
+	expect(notModified.getCode() == 304, name, "matching ETag not answered with 304");
+	expect(notModified.getBody() == nullptr, name, "304 with a body");
+	expect(notModified.getHeader(HeaderId::ETag) && *notModified.getHeader(HeaderId::ETag) == "\"v1\"", name,
+		"304 without ETag");
+	Response modified;
+	expect(pass(cache, makeRequest({{"If-None-Match", "\"v0\""}}), origin, modified), name,
+		"not served from the cache");
+	expect(modified.getCode() == 200 && getBody(modified) == "page", name, "other ETag not answered in full");
+}
+
+}
+
+void checkHeaderBlocks(void)
+{
+	const char *name = "header blocks";
+	Conf conf;
+	ResponseCache::Cache cache(conf);
+	Origin origin{200, {{"Cache-Control", "max-age=60"}}, "page"};
+	Response miss;
+	Response hit;
+
+	origin.block = {{"X-Frame-Options", "DENY"}, {"Content-Length", "4"}};
+	pass(cache, makeRequest({}), origin, miss);
+	expect(pass(cache, makeRequest({}), origin, hit), name, "not served from the cache");
+	Headers served;
+	for (const SharedBuffer &block : hit.getHeaderBlocks())
+		for (auto &header : parseHeaderBlock(*block))
+			served.push_back(std::move(header));
+	expect(served == Headers({{"Cache-Control", "max-age=60"}, {"X-Frame-Options", "DENY"}}), name,
+		"header block not stored, or transfer headers stored");
+
+	Origin cookie{200, {{"Cache-Control", "max-age=60"}}, "page"};
+	cookie.block = {{"Set-Cookie", "id=1"}};
+	expect(!isStored(cookie), "Set-Cookie in a header block", "stored");
+	Origin control{200, {}, "page"};
+	control.block = {{"Cache-Control", "private, max-age=60"}};
+	expect(!isStored(control), "Cache-Control in a header block", "stored");
+	control.block = {{"Cache-Control", "max-age=60"}};
+	expect(isStored(control), "lifetime in a header block", "not served from the cache");
+}
+
+int main(void)
+{
+	checkAdmission();
+	checkEviction();
+	checkExpiry();
+	checkBypass();
+	checkHit();
+	checkHeaderBlocks();
+	std::printf("%zu checks, %zu failures\n", checks, failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include "BodyStream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Zia::HttpParser {
+
+BodyStream::BodyStream(IRequest::IEmitter &emitter, std::optional<size_t> size, size_t capacity) :
+	m_emitter(&emitter),
+	m_size(size),
+	m_data(capacity),
+	m_begin(0),
+	m_end(0),
+	m_complete(false),
+	m_aborted(false),
+	m_wake(false),
+	m_abandoned(false),
+	m_listener(nullptr)
+{
+}
+
+size_t BodyStream::read(size_t buf_size, char *buf)
+{
+	size_t res = std::min(buf_size, m_end - m_begin);
+
+	std::memcpy(buf, m_data.data() + m_begin, res);
+	m_begin += res;
+	if (m_begin == m_end)
+		m_begin = m_end = 0;
+	if (res > 0)
+		wake();
+	return res;
+}
+
+std::optional<size_t> BodyStream::getSize(void) const
+{
+	return m_size;
+}
+
+bool BodyStream::isOver(void) const
+{
+	return m_complete && m_begin == m_end;
+}
+
+bool BodyStream::isAborted(void) const
+{
+	return m_aborted;
+}
+
+void BodyStream::setListener(IListener *listener)
+{
+	m_listener = listener;
+}
+
+size_t BodyStream::getSpace(void) const
+{
+	return m_data.size() - (m_end - m_begin);
+}
+
+void BodyStream::push(const char *data, size_t size)
+{
+	if (size == 0)
+		return;
+	if (m_data.size() - m_end < size) {
+		std::memmove(m_data.data(), m_data.data() + m_begin, m_end - m_begin);
+		m_end -= m_begin;
+		m_begin = 0;
+	}
+	std::memcpy(m_data.data() + m_end, data, size);
+	m_end += size;
+	if (m_listener != nullptr)
+		m_listener->onAvailable();
+}
+
+void BodyStream::complete(void)
+{
+	m_complete = true;
+	if (m_listener != nullptr)
+		m_listener->onAvailable();
+}
+
+void BodyStream::abort(void)
+{
+	m_aborted = true;
+	complete();
+}
+
+void BodyStream::wakeOnRead(void)
+{
+	m_wake = true;
+}
+
+void BodyStream::abandon(void)
+{
+	m_abandoned = true;
+	m_listener = nullptr;
+	wake();
+}
+
+bool BodyStream::isAbandoned(void) const
+{
+	return m_abandoned;
+}
+
+void BodyStream::detach(void)
+{
+	m_emitter = nullptr;
+	if (!m_complete)
+		abort();
+}
+
+void BodyStream::wake(void)
+{
+	if (m_wake && m_emitter != nullptr) {
+		m_wake = false;
+		m_emitter->wake();
+	}
+}
+
+}
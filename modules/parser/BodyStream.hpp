@@ -0,0 +1,100 @@
+#pragma once
+
+#include "zia/Zia.hpp"
+
+namespace Zia::HttpParser {
+
+/**
+* @class BodyStream
+* Request body streamed to handlers while it is being received.
+* Shared by the request and the parser instance feeding it.
+*/
+class BodyStream : public IBodySource
+{
+public:
+	/**
+	* @fn BodyStream
+	* Create a body stream.
+	* @param IRequest::IEmitter &emitter: the emitter to wake when a paused parser can feed the stream again
+	* @param std::optional<size_t> size: the body size, std::nullopt when unknown
+	* @param size_t capacity: maximum amount of bytes buffered in the stream
+	*/
+	BodyStream(IRequest::IEmitter &emitter, std::optional<size_t> size, size_t capacity);
+	~BodyStream(void) override = default;
+
+	size_t read(size_t buf_size, char *buf) override;
+	std::optional<size_t> getSize(void) const override;
+	bool isOver(void) const override;
+	bool isAborted(void) const override;
+	void setListener(IListener *listener) override;
+
+	/**
+	* @fn getSpace
+	* Get the amount of bytes the stream can accept.
+	* @return size_t: the free space
+	*/
+	size_t getSpace(void) const;
+
+	/**
+	* @fn push
+	* Append received bytes to the stream, and notify the listener.
+	* @param const char *data: the bytes to append
+	* @param size_t size: amount of bytes at data, at most `getSpace()`
+	*/
+	void push(const char *data, size_t size);
+
+	/**
+	* @fn complete
+	* Mark the body as entirely received, and notify the listener.
+	*/
+	void complete(void);
+
+	/**
+	* @fn abort
+	* Mark the body as truncated, and notify the listener.
+	*/
+	void abort(void);
+
+	/**
+	* @fn wakeOnRead
+	* Wake the parser once the reader frees some space.
+	*/
+	void wakeOnRead(void);
+
+	/**
+	* @fn abandon
+	* Mark the stream as abandoned by its reader, whose request is being destroyed.
+	* The rest of the body is then skipped by the parser.
+	*/
+	void abandon(void);
+
+	/**
+	* @fn isAbandoned
+	* Check whether the reader abandoned the stream.
+	* @return bool: true if the stream was abandoned, false otherwise
+	*/
+	bool isAbandoned(void) const;
+
+	/**
+	* @fn detach
+	* Detach the stream from its parser instance, which is being destroyed.
+	* The body is aborted if it was not entirely received.
+	*/
+	void detach(void);
+
+private:
+	IRequest::IEmitter *m_emitter;
+	std::optional<size_t> m_size;
+	std::vector<char> m_data;
+	size_t m_begin;
+	size_t m_end;
+	bool m_complete;
+	bool m_aborted;
+	bool m_wake;
+	bool m_abandoned;
+	IListener *m_listener;
+
+	void wake(void);
+};
+
+}
@@ -0,0 +1,460 @@
+#include "Instance.hpp"
+#include "Scanner.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Zia::HttpParser {
+
+namespace {
+
+using Phase = Module::IParser::Phase;
+
+// Maximum size of a chunk size line, extensions included
+constexpr size_t maxChunkLineSize = 1024;
+
+bool isTokenChar(char c)
+{
+	static constexpr std::string_view others = "!#$%&'*+-.^_`|~";
+
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+		others.find(c) != std::string_view::npos;
+}
+
+bool isToken(std::string_view str)
+{
+	return !str.empty() && std::all_of(str.begin(), str.end(), isTokenChar);
+}
+
+bool isWhitespace(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+std::string_view trim(std::string_view str)
+{
+	while (!str.empty() && isWhitespace(str.front()))
+		str.remove_prefix(1);
+	while (!str.empty() && isWhitespace(str.back()))
+		str.remove_suffix(1);
+	return str;
+}
+
+}
+
+Instance::Instance(const Config &config, IInput &input, ILogger &log, IRequest::IEmitter &emitter) :
+	m_config(config),
+	m_input(input),
+	m_log(log),
+	m_emitter(emitter),
+	m_state(State::RequestLine),
+	m_begin(0),
+	m_pos(0),
+	m_scan(0),
+	m_end(0),
+	m_remaining(0),
+	m_bodySize(0),
+	m_paused(false)
+{
+	// The server passes the default client connection as input stream
+	if (auto *connection = dynamic_cast<IConnection*>(&input))
+		m_clientIP = connection->getRemoteIP();
+}
+
+Instance::~Instance(void)
+{
+	if (m_stream)
+		m_stream->detach();
+}
+
+void Instance::parse(void)
+{
+	m_paused = false;
+	if (m_buf.empty())
+		m_buf = PooledBuffer(m_emitter.getBufferPool(), m_config.maxHeaderSize);
+	for (;;) {
+		compact();
+		size_t got = m_input.read(m_buf.size() - m_end, m_buf.data() + m_end);
+
+		if (m_state == State::Failed) {
+			// Input is drained and dropped: the stream cannot be resynchronized
+			if (got == 0)
+				break;
+			continue;
+		}
+		m_end += got;
+		process();
+		if (got == 0 || m_paused)
+			break;
+	}
+	// A pooled buffer is cheap to lease again: it is only held while a request is partly received
+	if (m_buf.isPooled() && isBetweenRequests())
+		releaseBuffer();
+}
+
+Readiness Instance::getReadiness(void) const
+{
+	// Unless paused, parse() always drains the input stream before returning
+	return m_paused ? Readiness::Paused : Readiness::NeedInput;
+}
+
+Module::IParser::Phase Instance::getPhase(void) const
+{
+	switch (m_state) {
+	case State::RequestLine:
+		return m_begin == m_end ? Phase::Idle : Phase::Head;
+	case State::Headers:
+		return Phase::Head;
+	case State::Failed:
+		return Phase::Idle;
+	default:
+		return Phase::Body;
+	}
+}
+
+bool Instance::hibernate(void)
+{
+	if (!isBetweenRequests() || (m_buf.empty() && m_head.headers.capacity() == 0))
+		return false;
+	releaseBuffer();
+	decltype(m_head.headers)().swap(m_head.headers);
+	return true;
+}
+
+bool Instance::isBetweenRequests(void) const
+{
+	// No byte of the next request was received, and the last body is complete
+	return (m_state == State::RequestLine || m_state == State::Failed) && m_begin == m_end && !m_stream;
+}
+
+void Instance::releaseBuffer(void)
+{
+	m_buf.reset();
+	m_begin = m_pos = m_scan = m_end = 0;
+}
+
+void Instance::process(void)
+{
+	Range line;
+
+	for (;;) {
+		switch (m_state) {
+		case State::RequestLine:
+		case State::Headers:
+			if (!nextLine(line)) {
+				if (m_state != State::Failed && m_end - m_begin >= m_config.maxHeaderSize)
+					fail("request head too large");
+				return;
+			}
+			if (m_state == State::RequestLine)
+				parseRequestLine(line);
+			else
+				parseHeaderLine(line);
+			break;
+		case State::ChunkSize:
+		case State::ChunkDataEnd:
+		case State::Trailers:
+			if (!nextLine(line)) {
+				if (m_state != State::Failed && m_end - m_pos >= maxChunkLineSize)
+					fail("chunk line too large");
+				return;
+			}
+			m_begin = m_pos;
+			if (m_state == State::ChunkSize)
+				parseChunkSize(line);
+			else if (m_state == State::ChunkDataEnd) {
+				if (line.begin != line.end)
+					fail("missing CRLF after chunk data");
+				else
+					m_state = State::ChunkSize;
+			} else if (line.begin == line.end)
+				endBody();
+			// Trailer fields are not exposed
+			break;
+		case State::Body:
+		case State::ChunkData:
+			if (m_pos == m_end || !consumeBody())
+				return;
+			break;
+		case State::Failed:
+			return;
+		}
+	}
+}
+
+bool Instance::nextLine(Range &line)
+{
+	const char *base = m_buf.data();
+	const char *found = Scanner::findLineBreak(base + m_scan, base + m_end);
+	size_t at = found - base;
+
+	if (at == m_end) {
+		m_scan = m_end;
+		return false;
+	}
+	if (*found == '\n') {
+		line = Range{m_pos, at};
+		m_pos = m_scan = at + 1;
+		return true;
+	}
+	if (*found == '\r') {
+		if (at + 1 == m_end) {
+			// Line break split across reads, CR is scanned again with the next bytes
+			m_scan = at;
+			return false;
+		}
+		if (base[at + 1] == '\n') {
+			line = Range{m_pos, at};
+			m_pos = m_scan = at + 2;
+			return true;
+		}
+	}
+	fail("invalid character in line");
+	return false;
+}
+
+void Instance::parseRequestLine(const Range &line)
+{
+	std::string_view str(m_buf.data() + line.begin, line.end - line.begin);
+
+	if (str.empty()) {
+		// Empty lines preceding a request are ignored
+		m_begin = m_pos;
+		return;
+	}
+	size_t methodEnd = str.find(' ');
+	size_t targetEnd = methodEnd == std::string_view::npos ? methodEnd : str.find(' ', methodEnd + 1);
+	if (targetEnd == std::string_view::npos) {
+		fail("malformed request line");
+		return;
+	}
+	std::string_view method = str.substr(0, methodEnd);
+	std::string_view target = str.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+	std::string_view protocol = str.substr(targetEnd + 1);
+	if (!isToken(method) || target.empty() || target.find(' ') != std::string_view::npos) {
+		fail("malformed request line");
+		return;
+	}
+	if (protocol.size() != 8 || protocol.substr(0, 5) != "HTTP/" || protocol[5] < '0' || protocol[5] > '9' ||
+		protocol[6] != '.' || protocol[7] < '0' || protocol[7] > '9') {
+		fail("unsupported protocol");
+		return;
+	}
+	size_t offset = line.begin - m_begin;
+	m_head.method = Range{offset, offset + methodEnd};
+	m_head.target = Range{offset + methodEnd + 1, offset + targetEnd};
+	m_head.protocol = Range{offset + targetEnd + 1, offset + str.size()};
+	m_head.headers.clear();
+	m_state = State::Headers;
+}
+
+void Instance::parseHeaderLine(const Range &line)
+{
+	std::string_view str(m_buf.data() + line.begin, line.end - line.begin);
+
+	if (str.empty()) {
+		endHead();
+		return;
+	}
+	if (isWhitespace(str.front())) {
+		fail("obsolete header line folding");
+		return;
+	}
+	size_t colon = str.find(':');
+	if (colon == std::string_view::npos || !isToken(str.substr(0, colon))) {
+		fail("malformed header");
+		return;
+	}
+	std::string_view value = trim(str.substr(colon + 1));
+	size_t offset = line.begin - m_begin;
+	size_t valueOffset = offset + (value.data() - str.data());
+	m_head.headers.push_back(Head::Header{
+		Range{offset, offset + colon},
+		Range{valueOffset, valueOffset + value.size()}
+	});
+}
+
+void Instance::endHead(void)
+{
+	std::string_view head(m_buf.data() + m_begin, m_pos - m_begin);
+
+	m_request = std::make_unique<Request>(m_emitter.getArena(), m_clientIP, head, m_head);
+	m_begin = m_pos;
+	m_bodySize = 0;
+
+	// Framing headers are checked on every occurrence, not only the first one the request exposes:
+	// conflicting framings are a request smuggling vector
+	std::optional<std::string_view> length;
+	std::optional<std::string_view> encoding; ///< Last coding of the joined Transfer-Encoding list
+	for (const Head::Header &header : m_head.headers) {
+		std::string_view key = head.substr(header.key.begin, header.key.end - header.key.begin);
+		std::string_view value = head.substr(header.value.begin, header.value.end - header.value.begin);
+		if (equalsIgnoreCase(key, "Content-Length")) {
+			if (length && *length != value) {
+				fail("conflicting Content-Length");
+				return;
+			}
+			length = value;
+		} else if (equalsIgnoreCase(key, "Transfer-Encoding")) {
+			size_t comma = value.rfind(',');
+			encoding = trim(comma == std::string_view::npos ? value : value.substr(comma + 1));
+		}
+	}
+	if (encoding) {
+		if (length || !equalsIgnoreCase(*encoding, "chunked")) {
+			fail("unsupported body framing");
+			return;
+		}
+		streamBody(std::nullopt);
+		m_state = State::ChunkSize;
+		return;
+	}
+	if (!length) {
+		endBody();
+		return;
+	}
+	size_t size = 0;
+	if (length->empty()) {
+		fail("invalid Content-Length");
+		return;
+	}
+	for (char c : *length) {
+		if (c < '0' || c > '9') {
+			fail("invalid Content-Length");
+			return;
+		}
+		size_t digit = static_cast<size_t>(c - '0');
+		// max_body_size may be as large as SIZE_MAX: only an overflow check is safe
+		if (size > (SIZE_MAX - digit) / 10) {
+			fail("body too large");
+			return;
+		}
+		size = size * 10 + digit;
+	}
+	if (size > m_config.maxBodySize) {
+		fail("body too large");
+		return;
+	}
+	if (size == 0) {
+		endBody();
+		return;
+	}
+	if (size > m_config.maxBufferedBodySize)
+		streamBody(size);
+	else
+		m_request->reserveBody(size);
+	m_remaining = size;
+	m_state = State::Body;
+}
+
+void Instance::streamBody(std::optional<size_t> size)
+{
+	m_stream = std::make_shared<BodyStream>(m_emitter, size, m_config.maxBufferedBodySize);
+	m_request->setBodyStream(m_stream);
+	m_emitter.emit(std::unique_ptr<IRequest>(std::move(m_request)));
+}
+
+void Instance::parseChunkSize(const Range &line)
+{
+	std::string_view str(m_buf.data() + line.begin, line.end - line.begin);
+	std::string_view digits = trim(str.substr(0, str.find(';')));
+	size_t size = 0;
+
+	if (digits.empty()) {
+		fail("invalid chunk size");
+		return;
+	}
+	for (char c : digits) {
+		int digit = c >= '0' && c <= '9' ? c - '0' :
+			c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+			c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+		if (digit < 0) {
+			fail("invalid chunk size");
+			return;
+		}
+		if (size > (SIZE_MAX - static_cast<size_t>(digit)) / 16) {
+			fail("body too large");
+			return;
+		}
+		size = size * 16 + static_cast<size_t>(digit);
+	}
+	if (size > m_config.maxBodySize - m_bodySize) {
+		fail("body too large");
+		return;
+	}
+	m_bodySize += size;
+	m_remaining = size;
+	m_state = size == 0 ? State::Trailers : State::ChunkData;
+}
+
+bool Instance::consumeBody(void)
+{
+	size_t size = std::min(m_end - m_pos, m_remaining);
+
+	if (!m_stream)
+		m_request->appendBody(m_buf.data() + m_pos, size);
+	else if (!m_stream->isAbandoned()) {
+		// Flow control: stop reading the client until the handler consumed the stream
+		size = std::min(size, m_stream->getSpace());
+		if (size == 0) {
+			m_paused = true;
+			m_stream->wakeOnRead();
+			return false;
+		}
+		m_stream->push(m_buf.data() + m_pos, size);
+	}
+	// Bodies of abandoned streams are skipped
+	m_pos += size;
+	m_scan = m_pos;
+	m_begin = m_pos;
+	m_remaining -= size;
+	if (m_remaining > 0)
+		return true;
+	if (m_state == State::ChunkData)
+		m_state = State::ChunkDataEnd;
+	else
+		endBody();
+	return true;
+}
+
+void Instance::endBody(void)
+{
+	m_state = State::RequestLine;
+	m_begin = m_pos;
+	if (m_stream) {
+		m_stream->complete();
+		m_stream.reset();
+	} else
+		m_emitter.emit(std::unique_ptr<IRequest>(std::move(m_request)));
+}
+
+void Instance::compact(void)
+{
+	if (m_begin == 0)
+		return;
+	// Only move unprocessed bytes when running out of space, or when there are none
+	if (m_begin != m_end && m_buf.size() - m_end >= m_buf.size() / 2)
+		return;
+	std::memmove(m_buf.data(), m_buf.data() + m_begin, m_end - m_begin);
+	m_end -= m_begin;
+	m_pos -= m_begin;
+	m_scan -= m_begin;
+	m_begin = 0;
+}
+
+void Instance::fail(const char *reason)
+{
+	m_state = State::Failed;
+	m_request.reset();
+	if (m_stream) {
+		// The streamed body is truncated
+		m_stream->abort();
+		m_stream.reset();
+	}
+	m_begin = m_pos = m_scan = m_end = 0;
+	if (m_log.isEnabled(LogLevel::Warning))
+		m_log.log(LogRecord{LogLevel::Warning, std::chrono::system_clock::now(), 0,
+			"parser: {} from {}, ignoring further input", {reason, m_clientIP}});
+}
+
+}
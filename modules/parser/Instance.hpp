@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Request.hpp"
+
+namespace Zia::HttpParser {
+
+/**
+* @struct Config
+* Parser module configuration.
+*/
+struct Config
+{
+	size_t maxHeaderSize = 16384; ///< Maximum size of a request head, which is also the receive buffer size
+	size_t maxBodySize = 8 * 1024 * 1024; ///< Maximum size of a request body
+	size_t maxBufferedBodySize = 64 * 1024; ///< Bodies with a larger or unknown size are streamed to handlers
+};
+
+/**
+* @class Instance
+* Incremental HTTP/1.1 parser for a single client.
+* Bytes are scanned only once: scanning resumes where it stopped when more bytes come in.
+* Small bodies are buffered, other requests are emitted right after their head and their body is streamed.
+*/
+class Instance : public Module::IParser::IInstance
+{
+public:
+	/**
+	* @fn Instance
+	* Create a parser instance.
+	* @param const Config &config: the parser module configuration
+	* @param IInput &input: the input stream
+	* @param ILogger &log: the logger associated with the input stream
+	* @param IRequest::IEmitter &emitter: the emitter where parsed requests go
+	*/
+	Instance(const Config &config, IInput &input, ILogger &log, IRequest::IEmitter &emitter);
+	~Instance(void) override;
+
+	void parse(void) override;
+	Readiness getReadiness(void) const override;
+	Module::IParser::Phase getPhase(void) const override;
+	bool hibernate(void) override;
+
+private:
+	enum class State
+	{
+		RequestLine,
+		Headers,
+		Body,
+		ChunkSize,
+		ChunkData,
+		ChunkDataEnd,
+		Trailers,
+		Failed
+	};
+
+	const Config &m_config;
+	IInput &m_input;
+	ILogger &m_log;
+	IRequest::IEmitter &m_emitter;
+	std::string m_clientIP;
+
+	State m_state;
+	PooledBuffer m_buf; ///< Receive buffer, empty between requests when pooled, and while hibernated
+	size_t m_begin; ///< First byte of the current request head
+	size_t m_pos; ///< First byte not processed yet
+	size_t m_scan; ///< First byte not scanned yet, at or after m_pos
+	size_t m_end; ///< Past the last received byte
+	Head m_head;
+	std::unique_ptr<Request> m_request;
+	size_t m_remaining; ///< Bytes left in the current body or chunk
+	size_t m_bodySize;
+	std::shared_ptr<BodyStream> m_stream; ///< Body of the emitted request being received, if streamed
+	bool m_paused; ///< Waiting for the body stream reader to free some space
+
+	void process(void);
+	bool nextLine(Range &line);
+	void parseRequestLine(const Range &line);
+	void parseHeaderLine(const Range &line);
+	void endHead(void);
+	void parseChunkSize(const Range &line);
+	void streamBody(std::optional<size_t> size);
+	bool consumeBody(void);
+	void endBody(void);
+	void compact(void);
+	bool isBetweenRequests(void) const;
+	void releaseBuffer(void);
+	void fail(const char *reason);
+};
+
+}
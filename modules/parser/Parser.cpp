@@ -0,0 +1,39 @@
+#include "Parser.hpp"
+
+#include "zia/module/Parser.hpp"
+
+namespace Zia::HttpParser {
+
+Parser::Parser(IConf &conf)
+{
+	std::shared_ptr<const Json::IObject> obj = conf.snapshot();
+
+	if (std::optional<Json::Integer> size = obj->getInteger("max_header_size"); size && *size > 0)
+		m_config.maxHeaderSize = static_cast<size_t>(*size);
+	if (std::optional<Json::Integer> size = obj->getInteger("max_body_size"); size && *size >= 0)
+		m_config.maxBodySize = static_cast<size_t>(*size);
+	if (std::optional<Json::Integer> size = obj->getInteger("max_buffered_body_size"); size && *size > 0)
+		m_config.maxBufferedBodySize = static_cast<size_t>(*size);
+}
+
+std::unique_ptr<Module::IParser::IInstance> Parser::create(IInput &input, ILogger &log, IRequest::IEmitter &requestEmitter)
+{
+	return std::make_unique<Instance>(m_config, input, log, requestEmitter);
+}
+
+}
+
+extern "C" {
+
+ZIA_EXPORT_SYMBOL Zia::Module::IParser* createParser(Zia::IConf &conf)
+{
+	return new Zia::HttpParser::Parser(conf);
+}
+
+ZIA_EXPORT_SYMBOL Zia::Module::Threading getModuleThreading(void)
+{
+	// The module only holds its configuration, instances are per client
+	return Zia::Module::Threading::Shared;
+}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Instance.hpp"
+
+namespace Zia::HttpParser {
+
+/**
+* @class Parser
+* Reference HTTP/1.1 parser module.
+* Configuration keys: `"max_header_size"` and `"max_body_size"`, in bytes.
+*/
+class Parser : public Module::IParser
+{
+public:
+	/**
+	* @fn Parser
+	* Create the module.
+	* @param IConf &conf: module configuration
+	*/
+	explicit Parser(IConf &conf);
+	~Parser(void) override = default;
+
+	std::unique_ptr<IInstance> create(IInput &input, ILogger &log, IRequest::IEmitter &requestEmitter) override;
+
+private:
+	Config m_config;
+};
+
+}
@@ -0,0 +1,188 @@
+#include "Request.hpp"
+
+namespace Zia::HttpParser {
+
+Request::Request(std::pmr::memory_resource &arena, const std::string &clientIP, std::string_view head, const Head &location) :
+	m_clientIP(clientIP),
+	m_head(head, &arena),
+	m_known(),
+	m_headers(&arena),
+	m_arguments(&arena)
+{
+	auto view = [this](const Range &range) {
+		return std::string_view(m_head.data() + range.begin, range.end - range.begin);
+	};
+
+	m_method = view(location.method);
+	m_protocol = view(location.protocol);
+	m_url = view(location.target);
+	m_headers.reserve(location.headers.size());
+	for (const Head::Header &header : location.headers) {
+		std::string_view key = view(header.key);
+		std::string_view value = view(header.value);
+		std::optional<HeaderId> id = findHeaderId(key);
+
+		if (id) {
+			// Well-known headers are exposed under their canonical name, first occurrence wins
+			key = getHeaderName(*id);
+			auto &slot = m_known[static_cast<size_t>(*id)];
+			if (!slot)
+				slot = value;
+		}
+		m_headers.push_back(Field{key, value});
+	}
+
+	std::string_view target = view(location.target);
+	size_t query = target.find('?');
+	m_filename = target.substr(0, query);
+	if (query == std::string_view::npos)
+		return;
+	std::string_view args = target.substr(query + 1);
+	while (!args.empty()) {
+		size_t amp = args.find('&');
+		std::string_view arg = args.substr(0, amp);
+		size_t eq = arg.find('=');
+
+		if (!arg.empty()) {
+			if (eq == std::string_view::npos)
+				m_arguments.push_back(Field{arg, std::string_view()});
+			else
+				m_arguments.push_back(Field{arg.substr(0, eq), arg.substr(eq + 1)});
+		}
+		if (amp == std::string_view::npos)
+			break;
+		args = args.substr(amp + 1);
+	}
+}
+
+Request::~Request(void)
+{
+	if (m_stream)
+		m_stream->abandon();
+}
+
+const std::string& Request::getClientIP(void) const
+{
+	return m_clientIP;
+}
+
+const std::string& Request::getMethod(void) const
+{
+	return m_method;
+}
+
+const std::string& Request::getProtocol(void) const
+{
+	return m_protocol;
+}
+
+const std::string& Request::getFilename(void) const
+{
+	return m_filename;
+}
+
+const std::string* Request::getArgument(const std::string &name) const
+{
+	return materialize(findArgument(name));
+}
+
+std::vector<std::string> Request::getArgumentsKeys(void) const
+{
+	std::vector<std::string> res;
+
+	res.reserve(m_arguments.size());
+	for (const Field &field : m_arguments)
+		res.emplace_back(field.key);
+	return res;
+}
+
+const std::string& Request::getURL(void) const
+{
+	return m_url;
+}
+
+const std::string* Request::getHeader(const std::string &key) const
+{
+	return materialize(findHeader(key));
+}
+
+std::vector<std::string> Request::getHeaderKeys(void) const
+{
+	std::vector<std::string> res;
+
+	res.reserve(m_headers.size());
+	for (const Field &field : m_headers)
+		res.emplace_back(field.key);
+	return res;
+}
+
+const std::vector<char>* Request::getBody(void) const
+{
+	return m_body ? &*m_body : nullptr;
+}
+
+IBodySource* Request::getBodySource(void) const
+{
+	return m_stream.get();
+}
+
+std::optional<std::string_view> Request::findArgument(std::string_view name) const
+{
+	for (const Field &field : m_arguments)
+		if (field.key == name)
+			return field.value;
+	return std::nullopt;
+}
+
+std::optional<std::string_view> Request::findHeader(std::string_view key) const
+{
+	for (const Field &field : m_headers)
+		if (equalsIgnoreCase(field.key, key))
+			return field.value;
+	return std::nullopt;
+}
+
+std::optional<std::string_view> Request::findHeader(HeaderId id) const
+{
+	return m_known[static_cast<size_t>(id)];
+}
+
+void Request::visitArguments(IFieldVisitor &visitor) const
+{
+	for (const Field &field : m_arguments)
+		visitor.visit(field.key, field.value);
+}
+
+void Request::visitHeaders(IFieldVisitor &visitor) const
+{
+	for (const Field &field : m_headers)
+		visitor.visit(field.key, field.value);
+}
+
+void Request::appendBody(const char *data, size_t size)
+{
+	if (!m_body)
+		m_body.emplace();
+	m_body->insert(m_body->end(), data, data + size);
+}
+
+void Request::reserveBody(size_t size)
+{
+	if (!m_body)
+		m_body.emplace();
+	m_body->reserve(size);
+}
+
+void Request::setBodyStream(std::shared_ptr<BodyStream> stream)
+{
+	m_stream = std::move(stream);
+}
+
+const std::string* Request::materialize(std::optional<std::string_view> value) const
+{
+	if (!value)
+		return nullptr;
+	return &m_materialized.try_emplace(value->data(), *value).first->second;
+}
+
+}
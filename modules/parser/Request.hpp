@@ -0,0 +1,126 @@
+#pragma once
+
+#include "BodyStream.hpp"
+
+#include <array>
+
+/**
+* @namespace Zia::HttpParser
+* Reference HTTP/1.1 parser module.
+*/
+namespace Zia::HttpParser {
+
+/**
+* @struct Range
+* Range of bytes, as offsets from the first byte of the request head.
+*/
+struct Range
+{
+	size_t begin;
+	size_t end;
+};
+
+/**
+* @struct Head
+* Location of request elements, recorded while scanning the request head.
+*/
+struct Head
+{
+	/**
+	* @struct Header
+	* Location of a header parameter.
+	*/
+	struct Header
+	{
+		Range key;
+		Range value;
+	};
+
+	Range method;
+	Range target;
+	Range protocol;
+	std::vector<Header> headers;
+};
+
+/**
+* @class Request
+* Parsed request. Keeps a single copy of the request head in the request arena,
+* every header and argument is a view into it.
+*/
+class Request : public IRequest
+{
+public:
+	/**
+	* @fn Request
+	* Create a request from its head.
+	* @param std::pmr::memory_resource &arena: the arena the request storage is allocated from
+	* @param const std::string &clientIP: the client IP
+	* @param std::string_view head: the raw request head, copied into the request
+	* @param const Head &location: the location of request elements within head
+	*/
+	Request(std::pmr::memory_resource &arena, const std::string &clientIP, std::string_view head, const Head &location);
+	~Request(void) override;
+
+	const std::string& getClientIP(void) const override;
+	const std::string& getMethod(void) const override;
+	const std::string& getProtocol(void) const override;
+	const std::string& getFilename(void) const override;
+	const std::string* getArgument(const std::string &name) const override;
+	std::vector<std::string> getArgumentsKeys(void) const override;
+	const std::string& getURL(void) const override;
+	const std::string* getHeader(const std::string &key) const override;
+	std::vector<std::string> getHeaderKeys(void) const override;
+	const std::vector<char>* getBody(void) const override;
+	IBodySource* getBodySource(void) const override;
+	std::optional<std::string_view> findArgument(std::string_view name) const override;
+	std::optional<std::string_view> findHeader(std::string_view key) const override;
+	std::optional<std::string_view> findHeader(HeaderId id) const override;
+	void visitArguments(IFieldVisitor &visitor) const override;
+	void visitHeaders(IFieldVisitor &visitor) const override;
+
+	/**
+	* @fn appendBody
+	* Append bytes to the request body, creating the body if needed.
+	* @param const char *data: the bytes to append
+	* @param size_t size: amount of bytes at data
+	*/
+	void appendBody(const char *data, size_t size);
+
+	/**
+	* @fn reserveBody
+	* Create the request body, and reserve storage for it.
+	* @param size_t size: amount of bytes to reserve
+	*/
+	void reserveBody(size_t size);
+
+	/**
+	* @fn setBodyStream
+	* Stream the request body instead of buffering it.
+	* @param std::shared_ptr<BodyStream> stream: the stream, also fed by the parser instance
+	*/
+	void setBodyStream(std::shared_ptr<BodyStream> stream);
+
+private:
+	struct Field
+	{
+		std::string_view key;
+		std::string_view value;
+	};
+
+	std::string m_clientIP;
+	std::string m_method;
+	std::string m_protocol;
+	std::string m_filename;
+	std::string m_url;
+	std::pmr::string m_head;
+	std::array<std::optional<std::string_view>, static_cast<size_t>(HeaderId::Count)> m_known;
+	std::pmr::vector<Field> m_headers;
+	std::pmr::vector<Field> m_arguments;
+	std::optional<std::vector<char>> m_body;
+	std::shared_ptr<BodyStream> m_stream;
+	mutable std::map<const char*, std::string> m_materialized;
+
+	const std::string* materialize(std::optional<std::string_view> value) const;
+};
+
+}
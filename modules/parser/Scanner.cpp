@@ -0,0 +1,106 @@
+#include "Scanner.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ZIA_PARSER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Zia::HttpParser::Scanner {
+
+namespace {
+
+bool isLineBreak(unsigned char c)
+{
+	return (c < 0x20 && c != '\t') || c == 0x7f;
+}
+
+const char* findLineBreakScalar(const char *begin, const char *end)
+{
+	for (; begin < end; begin++)
+		if (isLineBreak(static_cast<unsigned char>(*begin)))
+			return begin;
+	return end;
+}
+
+#ifdef ZIA_PARSER_X86
+
+__attribute__((target("sse4.2")))
+const char* findLineBreakSse42(const char *begin, const char *end)
+{
+	// Byte ranges matched by _mm_cmpestri: 0x00-0x08, 0x0a-0x1f, 0x7f-0x7f
+	const __m128i ranges = _mm_setr_epi8(0x00, 0x08, 0x0a, 0x1f, 0x7f, 0x7f, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+	for (; end - begin >= 16; begin += 16) {
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+		int index = _mm_cmpestri(ranges, 6, bytes, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+
+		if (index != 16)
+			return begin + index;
+	}
+	return findLineBreakScalar(begin, end);
+}
+
+__attribute__((target("avx2")))
+const char* findLineBreakAvx2(const char *begin, const char *end)
+{
+	const __m256i space = _mm256_set1_epi8(0x20);
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i del = _mm256_set1_epi8(0x7f);
+	const __m256i zero = _mm256_setzero_si256();
+
+	for (; end - begin >= 32; begin += 32) {
+		__m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+		// Signed comparison: bytes >= 0x80 are negative and must not be matched
+		__m256i ctl = _mm256_andnot_si256(_mm256_cmpgt_epi8(zero, bytes), _mm256_cmpgt_epi8(space, bytes));
+		__m256i match = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(bytes, tab), ctl),
+			_mm256_cmpeq_epi8(bytes, del));
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(match));
+
+		if (mask != 0)
+			return begin + __builtin_ctz(mask);
+	}
+	return findLineBreakSse42(begin, end);
+}
+
+#endif
+
+FN_findLineBreak* selectFindLineBreak(void)
+{
+	std::vector<Implementation> impls = getImplementations();
+
+	return impls.back().findLineBreak;
+}
+
+FN_findLineBreak *selected = selectFindLineBreak();
+
+}
+
+const char* findLineBreak(const char *begin, const char *end)
+{
+	return selected(begin, end);
+}
+
+void useImplementation(FN_findLineBreak *impl)
+{
+	selected = impl;
+}
+
+std::vector<Implementation> getImplementations(void)
+{
+	std::vector<Implementation> res{{"scalar", &findLineBreakScalar}};
+
+#ifdef ZIA_PARSER_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.2")) {
+		res.push_back({"sse4.2", &findLineBreakSse42});
+		if (__builtin_cpu_supports("avx2"))
+			res.push_back({"avx2", &findLineBreakAvx2});
+	}
+#endif
+	return res;
+}
+
+}
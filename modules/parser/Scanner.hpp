@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+/**
+* @namespace Zia::HttpParser::Scanner
+* Vectorized byte scanning for the HTTP/1.1 reference parser.
+*/
+namespace Zia::HttpParser::Scanner {
+
+/**
+* @typedef FN_findLineBreak
+* Find the first byte that cannot be part of a request line or a header line:
+* any control character other than HTAB, and DEL. CR and LF are such bytes.
+* @param const char *begin: first byte to scan
+* @param const char *end: past the last byte to scan
+* @return const char*: the first matching byte, end if none
+*/
+using FN_findLineBreak = const char* (const char *begin, const char *end);
+
+/**
+* @struct Implementation
+* A scanning implementation, available on the running CPU.
+*/
+struct Implementation
+{
+	const char *name;
+	FN_findLineBreak *findLineBreak;
+};
+
+/**
+* @fn findLineBreak
+* Find the first byte that cannot be part of a request line or a header line,
+* using the fastest implementation available on the running CPU (AVX2, SSE4.2 or scalar).
+* @param const char *begin: first byte to scan
+* @param const char *end: past the last byte to scan
+* @return const char*: the first matching byte, end if none
+*/
+const char* findLineBreak(const char *begin, const char *end);
+
+/**
+* @fn useImplementation
+* Force the implementation used by findLineBreak. Meant for benchmarks, not thread-safe.
+* @param FN_findLineBreak *impl: the implementation to use
+*/
+void useImplementation(FN_findLineBreak *impl);
+
+/**
+* @fn getImplementations
+* Get all implementations available on the running CPU, fastest last.
+* @return std::vector<Implementation>: the implementations
+*/
+std::vector<Implementation> getImplementations(void);
+
+}
@@ -0,0 +1,370 @@
+#include "../Instance.hpp"
+
+#include "BufferPool.hpp"
+#include "Support.hpp"
+
+#include <cstdio>
+
+/** @file
+ * Regression checks of the reference parser: raw requests are parsed, and the emitted requests and bodies
+ * are compared to the expected ones. Each input is parsed whole, then again byte by byte with a pooled receive buffer.
+ * Usage: `parser_check`, returns non-zero if a check fails. Also run by `ctest`.
+*/
+
+namespace {
+
+using namespace Zia;
+using namespace Zia::Support;
+
+using Phase = Module::IParser::Phase;
+
+/**
+* @struct Emitted
+* What a handler sees of an emitted request.
+*/
+struct Emitted
+{
+	std::string line; ///< Method, URL and protocol
+	std::string body;
+	bool complete; ///< The body ended normally
+};
+
+/**
+* @struct Check
+* Raw client input, and the requests expected from it.
+*/
+struct Check
+{
+	const char *name;
+	std::string input;
+	std::vector<Emitted> expected;
+	HttpParser::Config config = HttpParser::Config();
+};
+
+size_t failures = 0;
+
+void expect(bool condition, const char *name, const char *what)
+{
+	if (condition)
+		return;
+	std::printf("FAIL %s: %s\n", name, what);
+	failures++;
+}
+
+std::string readAll(IBodySource &source)
+{
+	std::string res;
+	char buf[256];
+
+	while (size_t got = source.read(sizeof(buf), buf))
+		res.append(buf, got);
+	return res;
+}
+
+/**
+* @fn collect
+* Read the emitted requests, and their bodies.
+* @param const CapturingEmitter &emitter: the emitter
+* @return std::vector<Emitted>: the emitted requests, in order
+*/
+std::vector<Emitted> collect(const CapturingEmitter &emitter)
+{
+	std::vector<Emitted> res;
+
+	for (const auto &request : emitter.getRequests()) {
+		Emitted emitted{request->getMethod() + " " + request->getURL() + " " + request->getProtocol(), "", true};
+		if (const std::vector<char> *body = request->getBody())
+			emitted.body.assign(body->begin(), body->end());
+		else if (IBodySource *source = request->getBodySource()) {
+			emitted.body = readAll(*source);
+			emitted.complete = source->isOver() && !source->isAborted();
+		}
+		res.push_back(std::move(emitted));
+	}
+	return res;
+}
+
+HttpParser::Config withMaxHeaderSize(size_t size)
+{
+	HttpParser::Config res;
+
+	res.maxHeaderSize = size;
+	return res;
+}
+
+HttpParser::Config withMaxBodySize(size_t size)
+{
+	HttpParser::Config res;
+
+	res.maxBodySize = size;
+	return res;
+}
+
+std::vector<Check> getChecks(void)
+{
+	const std::string get = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+	const std::string post = "POST / HTTP/1.1";
+
+	return {
+		// Request line
+		{"pipelined requests", get + get, {{"GET / HTTP/1.1", "", true}, {"GET / HTTP/1.1", "", true}}},
+		{"target with query", "GET /a/b.html?x=1&y HTTP/1.0\r\n\r\n", {{"GET /a/b.html?x=1&y HTTP/1.0", "", true}}},
+		{"empty lines before a request", "\r\n\r\n" + get, {{"GET / HTTP/1.1", "", true}}},
+		{"bare LF line breaks", "GET /lf HTTP/1.1\nHost: a\n\n", {{"GET /lf HTTP/1.1", "", true}}},
+		{"missing protocol", "GET /\r\n\r\n" + get, {}},
+		{"unsupported protocol", "GET / HTTP/2\r\n\r\n" + get, {}},
+		{"invalid method", "G(T / HTTP/1.1\r\n\r\n" + get, {}},
+		{"empty target", "GET  HTTP/1.1\r\n\r\n" + get, {}},
+		{"space in target", "GET /a b HTTP/1.1\r\n\r\n" + get, {}},
+		// Header lines
+		{"header without colon", "GET / HTTP/1.1\r\nHost a\r\n\r\n" + get, {}},
+		{"space in header name", "GET / HTTP/1.1\r\nHost : a\r\n\r\n" + get, {}},
+		{"obsolete line folding", "GET / HTTP/1.1\r\nX-A: a\r\n b\r\n\r\n" + get, {}},
+		{"bare CR in header", "GET / HTTP/1.1\r\nX-A: a\rb\r\n\r\n" + get, {}},
+		{"request head too large", "GET / HTTP/1.1\r\nX-A: " + std::string(64, 'a') + "\r\n\r\n", {},
+			withMaxHeaderSize(64)},
+		// Body framing
+		{"Content-Length body", post + "\r\nContent-Length: 3\r\n\r\nabc" + get,
+			{{post, "abc", true}, {"GET / HTTP/1.1", "", true}}},
+		{"repeated equal Content-Length", post + "\r\nContent-Length: 3\r\nContent-Length: 3\r\n\r\nabc",
+			{{post, "abc", true}}},
+		{"conflicting Content-Length", post + "\r\nContent-Length: 3\r\nContent-Length: 5\r\n\r\nabcde", {}},
+		{"invalid Content-Length", post + "\r\nContent-Length: 3a\r\n\r\nabc", {}},
+		{"Content-Length too large", post + "\r\nContent-Length: 8388609\r\n\r\nabc", {}},
+		// 2^64 + 3 wraps around to 3 on 64 bits when unchecked, whatever the configured maximum
+		{"Content-Length overflow", post + "\r\nContent-Length: 18446744073709551619\r\n\r\nabc" + get, {},
+			withMaxBodySize(SIZE_MAX)},
+		{"chunk size overflow", post + "\r\nTransfer-Encoding: chunked\r\n\r\n10000000000000003\r\nabc\r\n0\r\n\r\n" + get,
+			{{post, "", false}}, withMaxBodySize(SIZE_MAX)},
+		{"chunked body", post + "\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\n" + get,
+			{{post, "abc", true}, {"GET / HTTP/1.1", "", true}}},
+		{"chunked last of a list", post + "\r\nTransfer-Encoding: gzip, chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\n",
+			{{post, "abc", true}}},
+		{"chunked last of repeated headers",
+			post + "\r\nTransfer-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\n",
+			{{post, "abc", true}}},
+		{"chunked not last of repeated headers",
+			post + "\r\nTransfer-Encoding: chunked\r\nTransfer-Encoding: gzip\r\n\r\n3\r\nabc\r\n0\r\n\r\n", {}},
+		{"Content-Length with Transfer-Encoding",
+			post + "\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n\r\n", {}},
+		{"Transfer-Encoding then Content-Length",
+			post + "\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n3\r\nabc\r\n0\r\n\r\n", {}},
+		// Truncated bodies
+		{"malformed chunk size", post + "\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\nzz\r\n" + get,
+			{{post, "abc", false}}},
+		{"disconnection in a chunk", post + "\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nabc", {{post, "abc", false}}},
+		{"disconnection in a streamed body", post + "\r\nContent-Length: 100000\r\n\r\n12345678",
+			{{post, "12345678", false}}},
+	};
+}
+
+/**
+* @fn run
+* Parse the input of a check, and compare the emitted requests to the expected ones.
+* @param const Check &check: the check
+* @param size_t fragment: the amount of bytes coming in at once
+* @param bool pooled: whether the receive buffer is leased from a pool, which must get all its buffers back
+*/
+void run(const Check &check, size_t fragment, bool pooled)
+{
+	NullLogger log;
+	// Two buffers large enough for any head, leased again on every request
+	SlabPool pool(16384, 2 * 16384);
+	CapturingEmitter emitter(check.expected.size() + 1, pooled ? &pool : nullptr);
+	MemoryInput input(check.input, fragment);
+	bool idle = true;
+
+	{
+		HttpParser::Instance instance(check.config, input, log, emitter);
+		while (input.feed())
+			instance.parse();
+		// Unless the client left mid-request, nothing is held once the input is parsed
+		idle = instance.getPhase() != Phase::Idle || pool.getLeased() == 0;
+	}
+	expect(idle, check.name, "buffer held between requests");
+	expect(pool.getLeased() == 0, check.name, "buffer not released with the instance");
+	// Bodies are read once the client is gone, as a slow handler would
+	std::vector<Emitted> emitted = collect(emitter);
+	bool ok = emitter.getUnownedCount() == 0 && emitted.size() == check.expected.size();
+	for (size_t i = 0; ok && i < emitted.size(); i++)
+		ok = emitted[i].line == check.expected[i].line && emitted[i].body == check.expected[i].body &&
+			emitted[i].complete == check.expected[i].complete;
+	if (!ok) {
+		std::printf("FAIL %s (input by %zu bytes): %zu requests emitted, %zu expected\n", check.name, fragment,
+			emitted.size(), check.expected.size());
+		for (const Emitted &request : emitted)
+			std::printf("  %s, body \"%s\"%s\n", request.line.c_str(), request.body.c_str(),
+				request.complete ? "" : ", aborted");
+		failures++;
+	}
+}
+
+void checkFields(void)
+{
+	const std::string data = "GET /p?a=1&b=&c HTTP/1.1\r\nHost:  example  \r\nx-custom:v\r\nhost: second\r\n\r\n";
+	const char *name = "header and argument lookups";
+	HttpParser::Config config;
+	NullLogger log;
+	CapturingEmitter emitter(1);
+	MemoryInput input(data, data.size());
+	HttpParser::Instance instance(config, input, log, emitter);
+
+	input.feed();
+	instance.parse();
+	expect(emitter.getRequests().size() == 1, name, "request not emitted");
+	if (emitter.getRequests().empty())
+		return;
+	const IRequest &req = *emitter.getRequests().front();
+	expect(req.findHeader(std::string_view("HOST")) == std::string_view("example"), name, "trimmed, first value wins");
+	expect(req.findHeader(HeaderId::Host) == std::string_view("example"), name, "well-known header lookup");
+	expect(req.findHeader(std::string_view("X-Custom")) == std::string_view("v"), name, "case-insensitive lookup");
+	expect(!req.findHeader(std::string_view("X-Missing")), name, "missing header");
+	expect(req.getHeaderKeys().size() == 3, name, "every occurrence is kept");
+	expect(req.getFilename() == "/p", name, "filename without query");
+	expect(req.findArgument("a") == std::string_view("1"), name, "argument value");
+	expect(req.findArgument("b") == std::string_view(""), name, "empty argument value");
+	expect(req.findArgument("c").has_value(), name, "argument without value");
+	expect(!req.findArgument("d"), name, "missing argument");
+}
+
+void checkBackpressure(void)
+{
+	const std::string body(64, 'b');
+	const std::string data = "POST /up HTTP/1.1\r\nContent-Length: 64\r\n\r\n" + body + "GET /next HTTP/1.1\r\n\r\n";
+	const char *name = "streamed body backpressure";
+	HttpParser::Config config;
+	NullLogger log;
+	CapturingEmitter emitter(2);
+	MemoryInput input(data, data.size());
+
+	// Bodies larger than the stream capacity make the parser wait for the handler
+	config.maxBufferedBodySize = 16;
+	HttpParser::Instance instance(config, input, log, emitter);
+	input.feed();
+	instance.parse();
+	expect(emitter.getRequests().size() == 1, name, "request not emitted after its head");
+	expect(instance.getReadiness() == Readiness::Paused, name, "parser not paused on a full stream");
+	if (emitter.getRequests().size() != 1)
+		return;
+	IBodySource &source = *emitter.getRequests().front()->getBodySource();
+	std::string received;
+	for (size_t rounds = 0; instance.getReadiness() == Readiness::Paused && rounds < 64; rounds++) {
+		size_t wakes = emitter.getWakeCount();
+		received += readAll(source);
+		expect(emitter.getWakeCount() == wakes + 1, name, "reading the stream does not wake the parser");
+		instance.parse();
+	}
+	received += readAll(source);
+	expect(received == body, name, "body bytes lost or reordered");
+	expect(source.isOver() && !source.isAborted(), name, "body not complete");
+	expect(emitter.getRequests().size() == 2, name, "pipelined request not parsed after resuming");
+	expect(instance.getReadiness() == Readiness::NeedInput, name, "parser still paused");
+}
+
+void checkPhases(void)
+{
+	const std::string body(64, 'b');
+	const std::string head = "POST /up HTTP/1.1\r\nContent-Length: 64\r\n\r\n";
+	const std::string next = "GET /next HTTP/1.1\r\n\r\n";
+	const std::string data = head + body + next;
+	const char *name = "phase transitions";
+	HttpParser::Config config;
+	NullLogger log;
+	CapturingEmitter emitter(2);
+	MemoryInput input(data, data.size());
+
+	config.maxBufferedBodySize = 16;
+	HttpParser::Instance instance(config, input, log, emitter);
+	expect(instance.getPhase() == Phase::Idle, name, "new instance not idle");
+	input.feed(5);
+	instance.parse();
+	expect(instance.getPhase() == Phase::Head, name, "not in head after part of a request line");
+	input.feed(head.size() - 5);
+	instance.parse();
+	expect(instance.getPhase() == Phase::Body, name, "not in body once the head is parsed");
+	expect(emitter.getRequests().size() == 1, name, "streamed request not emitted after its head");
+	input.feed(body.size());
+	instance.parse();
+	expect(instance.getReadiness() == Readiness::Paused, name, "parser not paused on a full stream");
+	expect(instance.getPhase() == Phase::Body, name, "not in body while paused");
+	if (emitter.getRequests().size() != 1)
+		return;
+	IBodySource &source = *emitter.getRequests().front()->getBodySource();
+	for (size_t rounds = 0; instance.getReadiness() == Readiness::Paused && rounds < 64; rounds++) {
+		readAll(source);
+		instance.parse();
+	}
+	readAll(source);
+	expect(instance.getPhase() == Phase::Idle, name, "not idle once the body is complete");
+	input.feed(5);
+	instance.parse();
+	expect(instance.getPhase() == Phase::Head, name, "not in head after part of the next request line");
+	input.feed(next.size() - 5);
+	instance.parse();
+	expect(instance.getPhase() == Phase::Idle, name, "not idle after a request without body");
+	expect(emitter.getRequests().size() == 2, name, "next request not emitted");
+}
+
+void checkHibernation(void)
+{
+	const std::string get = "GET /first HTTP/1.1\r\nHost: a\r\n\r\n";
+	const std::string post = "POST /up HTTP/1.1\r\nContent-Length: 32\r\n\r\n" + std::string(32, 'b');
+	const std::string next = "GET /next HTTP/1.1\r\nHost: a\r\n\r\n";
+	const std::string data = get + post + next;
+	const char *name = "hibernation";
+	HttpParser::Config config;
+	NullLogger log;
+	CapturingEmitter emitter(3);
+	MemoryInput input(data, data.size());
+
+	config.maxBufferedBodySize = 16;
+	HttpParser::Instance instance(config, input, log, emitter);
+	input.feed(get.size() - 5);
+	instance.parse();
+	expect(!instance.hibernate(), name, "hibernated with a partial head");
+	input.feed(5);
+	instance.parse();
+	expect(instance.hibernate(), name, "nothing released between requests");
+	expect(!instance.hibernate(), name, "released twice");
+	input.feed(post.size() - 8);
+	instance.parse();
+	expect(!instance.hibernate(), name, "hibernated with an open body stream");
+	input.feed(8);
+	instance.parse();
+	if (emitter.getRequests().size() == 2) {
+		IBodySource &source = *emitter.getRequests().back()->getBodySource();
+		for (size_t rounds = 0; instance.getReadiness() == Readiness::Paused && rounds < 64; rounds++) {
+			readAll(source);
+			instance.parse();
+		}
+	}
+	// The next request comes in once the instance released its buffers
+	expect(instance.hibernate(), name, "nothing released after a streamed body");
+	input.feed(next.size());
+	instance.parse();
+	std::vector<Emitted> emitted = collect(emitter);
+	expect(emitted.size() == 3, name, "requests lost across hibernation");
+	if (emitted.size() != 3)
+		return;
+	expect(emitted[0].line == "GET /first HTTP/1.1", name, "partial head not kept");
+	expect(emitted[1].complete, name, "streamed body not complete");
+	expect(emitted[2].line == "GET /next HTTP/1.1", name, "next request not parsed after hibernation");
+}
+
+}
+
+int main(void)
+{
+	std::vector<Check> checks = getChecks();
+
+	for (const Check &check : checks) {
+		run(check, check.input.size(), false);
+		run(check, 1, true);
+	}
+	checkFields();
+	checkBackpressure();
+	checkPhases();
+	checkHibernation();
+	std::printf("%zu table checks, %zu failures\n", checks.size() * 2, failures);
+	return failures == 0 ? 0 : 1;
+}
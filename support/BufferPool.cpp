@@ -0,0 +1,53 @@
+#include "BufferPool.hpp"
+
+namespace Zia::Support {
+
+SlabPool::SlabPool(size_t bufferSize, size_t slabSize) :
+	m_bufferSize(bufferSize),
+	m_buffersPerSlab(std::max<size_t>(1, slabSize / bufferSize)),
+	m_leased(0),
+	m_maxLeased(0)
+{
+}
+
+size_t SlabPool::getBufferSize(void) const
+{
+	return m_bufferSize;
+}
+
+char* SlabPool::lease(void)
+{
+	if (m_free.empty()) {
+		m_slabs.push_back(std::make_unique<char[]>(m_bufferSize * m_buffersPerSlab));
+		// Handed out from the start of the slab first
+		for (size_t i = m_buffersPerSlab; i-- > 0;)
+			m_free.push_back(m_slabs.back().get() + i * m_bufferSize);
+	}
+	char *res = m_free.back();
+	m_free.pop_back();
+	m_maxLeased = std::max(m_maxLeased, ++m_leased);
+	return res;
+}
+
+void SlabPool::release(char *buffer)
+{
+	m_free.push_back(buffer);
+	m_leased--;
+}
+
+size_t SlabPool::getSlabCount(void) const
+{
+	return m_slabs.size();
+}
+
+size_t SlabPool::getLeased(void) const
+{
+	return m_leased;
+}
+
+size_t SlabPool::getMaxLeased(void) const
+{
+	return m_maxLeased;
+}
+
+}
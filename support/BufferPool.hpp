@@ -0,0 +1,56 @@
+#pragma once
+
+#include "zia/Zia.hpp"
+
+/** @file
+ * Buffer pool standing in for the per-shard pool of the server.
+*/
+
+namespace Zia::Support {
+
+/**
+* @class SlabPool
+* Buffer pool carving fixed-size buffers from slabs, recycled through a free list, as the server does per shard.
+* Slabs are only freed with the pool.
+*/
+class SlabPool : public IBufferPool
+{
+public:
+	/**
+	* @fn SlabPool
+	* Create an empty pool.
+	* @param size_t bufferSize: the size of the buffers
+	* @param size_t slabSize: the size of the slabs, rounded down to a multiple of bufferSize
+	*/
+	explicit SlabPool(size_t bufferSize = 16384, size_t slabSize = 1024 * 1024);
+
+	size_t getBufferSize(void) const override;
+	char* lease(void) override;
+	void release(char *buffer) override;
+
+	size_t getSlabCount(void) const;
+
+	/**
+	* @fn getLeased
+	* Get the amount of buffers currently leased.
+	* @return size_t: the buffer count
+	*/
+	size_t getLeased(void) const;
+
+	/**
+	* @fn getMaxLeased
+	* Get the highest amount of buffers leased at once.
+	* @return size_t: the buffer count
+	*/
+	size_t getMaxLeased(void) const;
+
+private:
+	size_t m_bufferSize;
+	size_t m_buffersPerSlab;
+	std::vector<std::unique_ptr<char[]>> m_slabs;
+	std::vector<char*> m_free;
+	size_t m_leased;
+	size_t m_maxLeased;
+};
+
+}
@@ -0,0 +1,423 @@
+#include "Exchange.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+namespace Zia::Support {
+
+namespace {
+
+// Writes that many times in a row without a byte accepted are taken for a gone client
+constexpr size_t maxStalls = 1024;
+
+// Writes all the bytes of the buffers, resuming after short writes. The buffers are consumed
+bool writeAll(IOutput &output, size_t count, ConstBuffer *bufs)
+{
+	for (size_t stalls = 0;;) {
+		while (count > 0 && bufs->size == 0) {
+			bufs++;
+			count--;
+		}
+		if (count == 0)
+			return true;
+		size_t written = output.writev(count, bufs);
+		stalls = written == 0 ? stalls + 1 : 0;
+		if (stalls == maxStalls)
+			return false;
+		for (; written > 0; bufs++, count--) {
+			if (written < bufs->size) {
+				bufs->data += written;
+				bufs->size -= written;
+				break;
+			}
+			written -= bufs->size;
+		}
+	}
+}
+
+}
+
+Request::Request(std::string method, std::string url) :
+	m_clientIP("127.0.0.1"),
+	m_method(std::move(method)),
+	m_protocol("HTTP/1.1"),
+	m_url(std::move(url))
+{
+	size_t query = m_url.find('?');
+	std::string_view arguments;
+
+	m_filename = m_url.substr(0, query);
+	if (query != std::string::npos)
+		arguments = std::string_view(m_url).substr(query + 1);
+	while (!arguments.empty()) {
+		size_t amp = arguments.find('&');
+		std::string_view argument = arguments.substr(0, amp);
+		size_t equal = argument.find('=');
+
+		m_arguments.emplace_back(std::string(argument.substr(0, equal)),
+			equal == std::string_view::npos ? std::string() : std::string(argument.substr(equal + 1)));
+		arguments.remove_prefix(amp == std::string_view::npos ? arguments.size() : amp + 1);
+	}
+}
+
+void Request::addHeader(std::string key, std::string value)
+{
+	m_headers.emplace_back(std::move(key), std::move(value));
+}
+
+const std::string& Request::getClientIP(void) const
+{
+	return m_clientIP;
+}
+
+const std::string& Request::getMethod(void) const
+{
+	return m_method;
+}
+
+const std::string& Request::getProtocol(void) const
+{
+	return m_protocol;
+}
+
+const std::string& Request::getFilename(void) const
+{
+	return m_filename;
+}
+
+const std::string* Request::getArgument(const std::string &name) const
+{
+	for (const auto &argument : m_arguments)
+		if (argument.first == name)
+			return &argument.second;
+	return nullptr;
+}
+
+std::vector<std::string> Request::getArgumentsKeys(void) const
+{
+	std::vector<std::string> res;
+
+	for (const auto &argument : m_arguments)
+		res.push_back(argument.first);
+	return res;
+}
+
+const std::string& Request::getURL(void) const
+{
+	return m_url;
+}
+
+const std::string* Request::getHeader(const std::string &key) const
+{
+	for (const auto &header : m_headers)
+		if (equalsIgnoreCase(header.first, key))
+			return &header.second;
+	return nullptr;
+}
+
+std::vector<std::string> Request::getHeaderKeys(void) const
+{
+	std::vector<std::string> res;
+
+	for (const auto &header : m_headers)
+		res.push_back(header.first);
+	return res;
+}
+
+const std::vector<char>* Request::getBody(void) const
+{
+	return nullptr;
+}
+
+BufferSource::BufferSource(SharedBuffer buffer) :
+	m_buffer(std::move(buffer)),
+	m_pos(0)
+{
+}
+
+size_t BufferSource::read(size_t buf_size, char *buf)
+{
+	size_t res = std::min(buf_size, m_buffer->size() - m_pos);
+
+	std::memcpy(buf, m_buffer->data() + m_pos, res);
+	m_pos += res;
+	return res;
+}
+
+std::optional<size_t> BufferSource::getSize(void) const
+{
+	return m_buffer->size();
+}
+
+bool BufferSource::isOver(void) const
+{
+	return m_pos == m_buffer->size();
+}
+
+Response::Response(void) :
+	m_aborted(false),
+	m_code(200),
+	m_hasBody(false)
+{
+}
+
+void Response::abortPipeline(void)
+{
+	m_aborted = true;
+}
+
+size_t Response::getCode(void) const
+{
+	return m_code;
+}
+
+void Response::setCode(size_t code)
+{
+	m_code = code;
+}
+
+const std::string* Response::getHeader(const std::string &key) const
+{
+	for (const auto &header : m_headers)
+		if (equalsIgnoreCase(header.first, key))
+			return &header.second;
+	return nullptr;
+}
+
+void Response::setHeader(const std::string &key, const std::string &value)
+{
+	if (auto *header = find(key))
+		header->second = value;
+	else
+		m_headers.emplace_back(key, value);
+}
+
+void Response::setHeader(std::string &&key, std::string &&value)
+{
+	if (auto *header = find(key))
+		header->second = std::move(value);
+	else
+		m_headers.emplace_back(std::move(key), std::move(value));
+}
+
+const std::vector<char>* Response::getBody(void) const
+{
+	if (m_source)
+		return nullptr;
+	if (m_sharedBody)
+		return m_sharedBody.get();
+	return m_hasBody ? &m_body : nullptr;
+}
+
+void Response::setBody(const std::vector<char> &body)
+{
+	clearBody();
+	m_body = body;
+	m_hasBody = true;
+}
+
+void Response::setBody(std::vector<char> &&body)
+{
+	clearBody();
+	m_body = std::move(body);
+	m_hasBody = true;
+}
+
+void Response::setBody(SharedBuffer body)
+{
+	clearBody();
+	m_sharedBody = std::move(body);
+}
+
+std::vector<char> Response::takeBody(void)
+{
+	std::vector<char> res;
+
+	if (m_source)
+		return res;
+	if (m_sharedBody)
+		res = *m_sharedBody;
+	else
+		res = std::move(m_body);
+	setBody(std::vector<char>());
+	return res;
+}
+
+void Response::setBodySource(std::unique_ptr<IBodySource> source)
+{
+	clearBody();
+	m_source = std::move(source);
+}
+
+std::unique_ptr<IBodySource> Response::takeBodySource(void)
+{
+	std::unique_ptr<IBodySource> res;
+
+	if (m_source)
+		res = std::move(m_source);
+	else if (m_sharedBody)
+		res = std::make_unique<BufferSource>(m_sharedBody);
+	else if (m_hasBody)
+		res = std::make_unique<BufferSource>(std::make_shared<const std::vector<char>>(std::move(m_body)));
+	clearBody();
+	return res;
+}
+
+void Response::visitHeaders(IRequest::IFieldVisitor &visitor) const
+{
+	for (const auto &header : m_headers)
+		visitor.visit(header.first, header.second);
+}
+
+void Response::addHeaderBlock(SharedBuffer block)
+{
+	m_blocks.push_back(std::move(block));
+}
+
+std::vector<SharedBuffer> Response::getHeaderBlocks(void) const
+{
+	return m_blocks;
+}
+
+bool Response::isAborted(void) const
+{
+	return m_aborted;
+}
+
+bool Response::write(IOutput &output, std::string_view date, IBufferPool &pool)
+{
+	std::string_view statusLine = getStatusLine(m_code);
+	std::string head;
+	std::vector<ConstBuffer> bufs;
+	char contentLength[48];
+
+	if (statusLine.empty()) {
+		head = "HTTP/1.1 " + std::to_string(m_code) + " Unknown\r\n";
+		statusLine = head;
+	}
+	bufs.push_back(ConstBuffer{statusLine.data(), statusLine.size()});
+	bufs.push_back(ConstBuffer{date.data(), date.size()});
+
+	std::string headers;
+	for (const auto &header : m_headers) {
+		headers += header.first;
+		headers += ": ";
+		headers += header.second;
+		headers += "\r\n";
+	}
+	const std::vector<char> *body = getBody();
+	std::optional<size_t> size = body ? std::optional<size_t>(body->size()) : m_source ? m_source->getSize() : 0;
+	if (size) {
+		int length = std::snprintf(contentLength, sizeof(contentLength), "Content-Length: %zu\r\n", *size);
+		headers.append(contentLength, static_cast<size_t>(length));
+	} else
+		headers += "Transfer-Encoding: chunked\r\n";
+	bufs.push_back(ConstBuffer{headers.data(), headers.size()});
+	for (const SharedBuffer &block : m_blocks)
+		bufs.push_back(ConstBuffer{block->data(), block->size()});
+	bufs.push_back(ConstBuffer{"\r\n", 2});
+	if (body)
+		bufs.push_back(ConstBuffer{body->data(), body->size()});
+	if (!writeAll(output, bufs.size(), bufs.data()))
+		return false;
+
+	if (!m_source)
+		return true;
+	// Pulled by chunks, as the client connection accepts more bytes
+	PooledBuffer buf(&pool, pool.getBufferSize());
+	while (!m_source->isOver()) {
+		size_t got = m_source->read(buf.size(), buf.data());
+		// Sources are read synchronously: one with nothing to give before its end is cut short
+		if (got == 0)
+			return false;
+		if (size) {
+			ConstBuffer data{buf.data(), got};
+			if (!writeAll(output, 1, &data))
+				return false;
+		} else {
+			int length = std::snprintf(contentLength, sizeof(contentLength), "%zx\r\n", got);
+			ConstBuffer chunk[3] = {{contentLength, static_cast<size_t>(length)}, {buf.data(), got}, {"\r\n", 2}};
+			if (!writeAll(output, 3, chunk))
+				return false;
+		}
+	}
+	// A truncated body must not look complete: no last chunk
+	if (m_source->isAborted())
+		return false;
+	ConstBuffer last{"0\r\n\r\n", 5};
+	return size || writeAll(output, 1, &last);
+}
+
+std::pair<std::string, std::string>* Response::find(const std::string &key)
+{
+	for (auto &header : m_headers)
+		if (equalsIgnoreCase(header.first, key))
+			return &header;
+	return nullptr;
+}
+
+void Response::clearBody(void)
+{
+	m_hasBody = false;
+	m_body.clear();
+	m_sharedBody.reset();
+	m_source.reset();
+}
+
+Context::Context(std::pmr::memory_resource &arena) :
+	m_arena(arena)
+{
+}
+
+Context::~Context(void)
+{
+	for (auto slot = m_slots.rbegin(); slot != m_slots.rend(); slot++)
+		if (slot->value != nullptr && slot->destroy != nullptr)
+			slot->destroy(slot->value);
+}
+
+const std::any* Context::get(const std::string &key) const
+{
+	auto found = m_values.find(key);
+
+	return found == m_values.end() ? nullptr : &found->second;
+}
+
+void Context::set(const std::string &key, const std::any &value)
+{
+	m_values[key] = value;
+}
+
+std::pmr::memory_resource& Context::getArena(void)
+{
+	return m_arena;
+}
+
+size_t Context::getSlotIndex(const std::string &name) const
+{
+	static std::mutex mutex;
+	static std::unordered_map<std::string, size_t> indices;
+	std::lock_guard<std::mutex> lock(mutex);
+
+	return indices.emplace(name, indices.size()).first->second;
+}
+
+void* Context::getSlot(size_t index) const
+{
+	return index < m_slots.size() ? m_slots[index].value : nullptr;
+}
+
+void Context::setSlot(size_t index, void *value, void (*destroy)(void *value))
+{
+	if (index >= m_slots.size())
+		m_slots.resize(index + 1);
+	Slot &slot = m_slots[index];
+	if (slot.value != nullptr && slot.destroy != nullptr)
+		slot.destroy(slot.value);
+	slot = Slot{value, destroy};
+}
+
+}
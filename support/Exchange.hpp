@@ -0,0 +1,166 @@
+#pragma once
+
+#include "zia/Zia.hpp"
+
+#include <map>
+
+/** @file
+ * In-memory stand-ins for the objects the server hands to handlers: request, response and context.
+*/
+
+namespace Zia::Support {
+
+/**
+* @class Request
+* Fixed in-memory request, as a parser would emit it: handlers see a GET without body by default.
+*/
+class Request : public IRequest
+{
+public:
+	/**
+	* @fn Request
+	* Create a request.
+	* @param std::string method: the request method
+	* @param std::string url: the request target, query included
+	*/
+	Request(std::string method, std::string url);
+
+	/**
+	* @fn addHeader
+	* Add a header field. Repeated keys keep every occurrence, the first one is found.
+	* @param std::string key: the header key
+	* @param std::string value: the header value
+	*/
+	void addHeader(std::string key, std::string value);
+
+	const std::string& getClientIP(void) const override;
+	const std::string& getMethod(void) const override;
+	const std::string& getProtocol(void) const override;
+	const std::string& getFilename(void) const override;
+	const std::string* getArgument(const std::string &name) const override;
+	std::vector<std::string> getArgumentsKeys(void) const override;
+	const std::string& getURL(void) const override;
+	const std::string* getHeader(const std::string &key) const override;
+	std::vector<std::string> getHeaderKeys(void) const override;
+	const std::vector<char>* getBody(void) const override;
+
+	using IRequest::getHeader;
+
+private:
+	std::string m_clientIP;
+	std::string m_method;
+	std::string m_protocol;
+	std::string m_url;
+	std::string m_filename;
+	std::vector<std::pair<std::string, std::string>> m_arguments;
+	std::vector<std::pair<std::string, std::string>> m_headers;
+};
+
+/**
+* @class BufferSource
+* Body source reading a shared buffer.
+*/
+class BufferSource : public IBodySource
+{
+public:
+	explicit BufferSource(SharedBuffer buffer);
+
+	size_t read(size_t buf_size, char *buf) override;
+	std::optional<size_t> getSize(void) const override;
+	bool isOver(void) const override;
+
+private:
+	SharedBuffer m_buffer;
+	size_t m_pos;
+};
+
+/**
+* @class Response
+* In-memory response, serialized the way the server does: one vectored write of the status line,
+* the cached Date header, header parameters, header blocks and body.
+*/
+class Response : public IResponse
+{
+public:
+	Response(void);
+
+	void abortPipeline(void) override;
+	size_t getCode(void) const override;
+	void setCode(size_t code) override;
+	const std::string* getHeader(const std::string &key) const override;
+	void setHeader(const std::string &key, const std::string &value) override;
+	void setHeader(std::string &&key, std::string &&value) override;
+	const std::vector<char>* getBody(void) const override;
+	void setBody(const std::vector<char> &body) override;
+	void setBody(std::vector<char> &&body) override;
+	void setBody(SharedBuffer body) override;
+	std::vector<char> takeBody(void) override;
+	void setBodySource(std::unique_ptr<IBodySource> source) override;
+	std::unique_ptr<IBodySource> takeBodySource(void) override;
+	void visitHeaders(IRequest::IFieldVisitor &visitor) const override;
+	void addHeaderBlock(SharedBuffer block) override;
+	std::vector<SharedBuffer> getHeaderBlocks(void) const override;
+
+	using IResponse::getHeader;
+	using IResponse::setHeader;
+
+	bool isAborted(void) const;
+
+	/**
+	* @fn write
+	* Serialize the response. Short writes are resumed, and a streamed body is read until its end.
+	* @param IOutput &output: the client output
+	* @param std::string_view date: the Date header line, CRLF included
+	* @param IBufferPool &pool: the pool streamed bodies are read through
+	* @return bool: false if the response was cut short, because the output stopped accepting bytes or the
+	* streamed body ended aborted or stalled. The last chunk is then not written, and the connection must be closed.
+	*/
+	bool write(IOutput &output, std::string_view date, IBufferPool &pool);
+
+private:
+	bool m_aborted;
+	size_t m_code;
+	std::vector<std::pair<std::string, std::string>> m_headers;
+	std::vector<SharedBuffer> m_blocks;
+	bool m_hasBody;
+	std::vector<char> m_body;
+	SharedBuffer m_sharedBody;
+	std::unique_ptr<IBodySource> m_source;
+
+	std::pair<std::string, std::string>* find(const std::string &key);
+	void clearBody(void);
+};
+
+/**
+* @class Context
+* In-memory request context, backed by the request arena.
+*/
+class Context : public IContext
+{
+public:
+	explicit Context(std::pmr::memory_resource &arena);
+	~Context(void) override;
+
+	const std::any* get(const std::string &key) const override;
+	void set(const std::string &key, const std::any &value) override;
+	std::pmr::memory_resource& getArena(void) override;
+	size_t getSlotIndex(const std::string &name) const override;
+	void* getSlot(size_t index) const override;
+	void setSlot(size_t index, void *value, void (*destroy)(void *value)) override;
+
+	using IContext::get;
+	using IContext::set;
+
+private:
+	struct Slot
+	{
+		void *value = nullptr;
+		void (*destroy)(void *value) = nullptr;
+	};
+
+	std::pmr::memory_resource &m_arena;
+	std::map<std::string, std::any> m_values;
+	std::vector<Slot> m_slots;
+};
+
+}
@@ -0,0 +1,316 @@
+#include "Json.hpp"
+
+namespace Zia::Support {
+
+namespace {
+
+Value cloneValue(const Value &value)
+{
+	if (auto *object = std::get_if<std::shared_ptr<Object>>(&value))
+		return std::shared_ptr<Object>((*object)->clone());
+	if (auto *array = std::get_if<std::shared_ptr<Array>>(&value))
+		return std::shared_ptr<Array>((*array)->clone());
+	return value;
+}
+
+void copyObject(const Json::IObject &source, Json::IObject &destination);
+void copyArray(const Json::IArray &source, Json::IArray &destination);
+
+// Copy an entry from any configuration implementation, trying each JSON type
+template <typename Source, typename Destination, typename Key>
+void copyEntry(const Source &source, Destination &destination, Key key)
+{
+	if (const Json::IObject *object = source.getObject(key))
+		copyObject(*object, destination.createEmptyObject(key));
+	else if (const Json::IArray *array = source.getArray(key))
+		copyArray(*array, destination.createEmptyArray(key));
+	else if (std::optional<Json::Integer> integer = source.getInteger(key))
+		destination.setInteger(key, *integer);
+	else if (std::optional<Json::Number> number = source.getNumber(key))
+		destination.setNumber(key, *number);
+	else if (std::optional<Json::String> string = source.getString(key))
+		destination.setString(key, *string);
+	else if (std::optional<Json::Bool> boolean = source.getBool(key))
+		destination.setBool(key, *boolean);
+	else if (source.isNull(key))
+		destination.setNull(key);
+}
+
+void copyObject(const Json::IObject &source, Json::IObject &destination)
+{
+	for (const std::string &key : source.getKeys())
+		copyEntry(source, destination, key);
+}
+
+void copyArray(const Json::IArray &source, Json::IArray &destination)
+{
+	for (size_t i = 0; i < source.getSize(); i++)
+		copyEntry(source, destination, i);
+}
+
+}
+
+template <typename Base, typename Key>
+std::optional<Json::Number> Container<Base, Key>::getNumber(Key key) const
+{
+	const Value *value = find(key);
+
+	if (value == nullptr)
+		return std::nullopt;
+	if (auto *number = std::get_if<Json::Number>(value))
+		return *number;
+	if (auto *integer = std::get_if<Json::Integer>(value))
+		return static_cast<Json::Number>(*integer);
+	return std::nullopt;
+}
+
+template <typename Base, typename Key>
+std::optional<Json::Integer> Container<Base, Key>::getInteger(Key key) const
+{
+	const Value *value = find(key);
+
+	if (value == nullptr || !std::holds_alternative<Json::Integer>(*value))
+		return std::nullopt;
+	return std::get<Json::Integer>(*value);
+}
+
+template <typename Base, typename Key>
+std::optional<Json::String> Container<Base, Key>::getString(Key key) const
+{
+	const Value *value = find(key);
+
+	if (value == nullptr || !std::holds_alternative<Json::String>(*value))
+		return std::nullopt;
+	return std::get<Json::String>(*value);
+}
+
+template <typename Base, typename Key>
+std::optional<Json::Bool> Container<Base, Key>::getBool(Key key) const
+{
+	const Value *value = find(key);
+
+	if (value == nullptr || !std::holds_alternative<Json::Bool>(*value))
+		return std::nullopt;
+	return std::get<Json::Bool>(*value);
+}
+
+template <typename Base, typename Key>
+bool Container<Base, Key>::isNull(Key key) const
+{
+	const Value *value = find(key);
+
+	return value != nullptr && std::holds_alternative<std::nullptr_t>(*value);
+}
+
+template <typename Base, typename Key>
+bool Container<Base, Key>::isUndefined(Key key) const
+{
+	const Value *value = find(key);
+
+	return value == nullptr || std::holds_alternative<std::monostate>(*value);
+}
+
+template <typename Base, typename Key>
+const Json::IObject* Container<Base, Key>::getObject(Key key) const
+{
+	const Value *value = find(key);
+
+	if (value == nullptr || !std::holds_alternative<std::shared_ptr<Object>>(*value))
+		return nullptr;
+	return std::get<std::shared_ptr<Object>>(*value).get();
+}
+
+template <typename Base, typename Key>
+const Json::IArray* Container<Base, Key>::getArray(Key key) const
+{
+	const Value *value = find(key);
+
+	if (value == nullptr || !std::holds_alternative<std::shared_ptr<Array>>(*value))
+		return nullptr;
+	return std::get<std::shared_ptr<Array>>(*value).get();
+}
+
+template <typename Base, typename Key>
+void Container<Base, Key>::setNumber(Key key, Json::Number value)
+{
+	at(key) = value;
+}
+
+template <typename Base, typename Key>
+void Container<Base, Key>::setInteger(Key key, Json::Integer value)
+{
+	at(key) = value;
+}
+
+template <typename Base, typename Key>
+void Container<Base, Key>::setString(Key key, const Json::String &value)
+{
+	at(key) = value;
+}
+
+template <typename Base, typename Key>
+void Container<Base, Key>::setBool(Key key, Json::Bool value)
+{
+	at(key) = value;
+}
+
+template <typename Base, typename Key>
+void Container<Base, Key>::setNull(Key key)
+{
+	at(key) = nullptr;
+}
+
+template <typename Base, typename Key>
+void Container<Base, Key>::setUndefined(Key key)
+{
+	at(key) = std::monostate();
+}
+
+template <typename Base, typename Key>
+Json::IObject* Container<Base, Key>::getObject(Key key)
+{
+	return const_cast<Json::IObject*>(static_cast<const Container&>(*this).getObject(key));
+}
+
+template <typename Base, typename Key>
+Json::IArray* Container<Base, Key>::getArray(Key key)
+{
+	return const_cast<Json::IArray*>(static_cast<const Container&>(*this).getArray(key));
+}
+
+template <typename Base, typename Key>
+Json::IObject& Container<Base, Key>::createEmptyObject(Key key)
+{
+	auto res = std::make_shared<Object>();
+
+	at(key) = res;
+	return *res;
+}
+
+template <typename Base, typename Key>
+Json::IArray& Container<Base, Key>::createEmptyArray(Key key)
+{
+	auto res = std::make_shared<Array>();
+
+	at(key) = res;
+	return *res;
+}
+
+template class Container<Json::IObject, const std::string&>;
+template class Container<Json::IArray, size_t>;
+
+void Object::clear(void)
+{
+	m_values.clear();
+}
+
+std::vector<std::string> Object::getKeys(void) const
+{
+	std::vector<std::string> res;
+
+	res.reserve(m_values.size());
+	for (const auto &value : m_values)
+		if (!std::holds_alternative<std::monostate>(value.second))
+			res.push_back(value.first);
+	return res;
+}
+
+std::unique_ptr<Object> Object::clone(void) const
+{
+	auto res = std::make_unique<Object>();
+
+	for (const auto &value : m_values)
+		res->m_values.emplace(value.first, cloneValue(value.second));
+	return res;
+}
+
+const Value* Object::find(const std::string &key) const
+{
+	auto found = m_values.find(key);
+
+	return found == m_values.end() ? nullptr : &found->second;
+}
+
+Value& Object::at(const std::string &key)
+{
+	return m_values[key];
+}
+
+void Array::clear(void)
+{
+	m_values.clear();
+}
+
+size_t Array::getSize(void) const
+{
+	return m_values.size();
+}
+
+void Array::remove(size_t index)
+{
+	if (index < m_values.size())
+		m_values.erase(m_values.begin() + index);
+}
+
+std::unique_ptr<Array> Array::clone(void) const
+{
+	auto res = std::make_unique<Array>();
+
+	res->m_values.reserve(m_values.size());
+	for (const Value &value : m_values)
+		res->m_values.push_back(cloneValue(value));
+	return res;
+}
+
+const Value* Array::find(size_t index) const
+{
+	return index < m_values.size() ? &m_values[index] : nullptr;
+}
+
+Value& Array::at(size_t index)
+{
+	if (index >= m_values.size())
+		m_values.resize(index + 1);
+	return m_values[index];
+}
+
+Conf::Conf(void) :
+	m_object(std::make_shared<Object>()),
+	m_generation(0)
+{
+}
+
+std::unique_ptr<Json::IObject> Conf::read(void) const
+{
+	return m_object->clone();
+}
+
+void Conf::write(const Json::IObject &jsonObject)
+{
+	auto object = std::make_shared<Object>();
+
+	copyObject(jsonObject, *object);
+	m_object = std::move(object);
+	m_generation++;
+}
+
+std::shared_ptr<const Json::IObject> Conf::snapshot(void) const
+{
+	return m_object;
+}
+
+uint64_t Conf::getGeneration(void) const
+{
+	return m_generation;
+}
+
+Object& Conf::edit(void)
+{
+	// Snapshots handed out are immutable: edit a copy
+	if (m_object.use_count() > 1)
+		m_object = m_object->clone();
+	m_generation++;
+	return *m_object;
+}
+
+}
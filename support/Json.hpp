@@ -0,0 +1,145 @@
+#pragma once
+
+#include "zia/Zia.hpp"
+
+/** @file
+ * In-memory JSON containers and module configuration.
+*/
+
+namespace Zia::Support {
+
+class Object;
+class Array;
+
+/**
+* @typedef Value
+* JSON value held by the in-memory containers. std::monostate is undefined.
+*/
+using Value = std::variant<std::monostate, std::nullptr_t, Json::Number, Json::Integer, Json::String, Json::Bool,
+	std::shared_ptr<Object>, std::shared_ptr<Array>>;
+
+/**
+* @class Container
+* In-memory implementation of Json::IContainer, shared by objects and arrays.
+* @param typename Base: the implemented interface, Json::IObject or Json::IArray
+* @param typename Key: the key type of the container
+*/
+template <typename Base, typename Key>
+class Container : public Base
+{
+public:
+	std::optional<Json::Number> getNumber(Key key) const override;
+	std::optional<Json::Integer> getInteger(Key key) const override;
+	std::optional<Json::String> getString(Key key) const override;
+	std::optional<Json::Bool> getBool(Key key) const override;
+	bool isNull(Key key) const override;
+	bool isUndefined(Key key) const override;
+	const Json::IObject* getObject(Key key) const override;
+	const Json::IArray* getArray(Key key) const override;
+
+	void setNumber(Key key, Json::Number value) override;
+	void setInteger(Key key, Json::Integer value) override;
+	void setString(Key key, const Json::String &value) override;
+	void setBool(Key key, Json::Bool value) override;
+	void setNull(Key key) override;
+	void setUndefined(Key key) override;
+	Json::IObject* getObject(Key key) override;
+	Json::IArray* getArray(Key key) override;
+	Json::IObject& createEmptyObject(Key key) override;
+	Json::IArray& createEmptyArray(Key key) override;
+
+protected:
+	/**
+	* @fn find
+	* Get the value at a key.
+	* @return const Value*: the value, nullptr if undefined
+	*/
+	virtual const Value* find(Key key) const = 0;
+
+	/**
+	* @fn at
+	* Get the value at a key, creating it undefined if needed.
+	* @return Value&: the value
+	*/
+	virtual Value& at(Key key) = 0;
+};
+
+/**
+* @class Object
+* In-memory JSON object.
+*/
+class Object : public Container<Json::IObject, const std::string&>
+{
+public:
+	void clear(void) override;
+	std::vector<std::string> getKeys(void) const override;
+
+	/**
+	* @fn clone
+	* Deep copy the object, as a server reading its configuration file would.
+	* @return std::unique_ptr<Object>: the copy
+	*/
+	std::unique_ptr<Object> clone(void) const;
+
+protected:
+	const Value* find(const std::string &key) const override;
+	Value& at(const std::string &key) override;
+
+private:
+	std::map<std::string, Value> m_values;
+};
+
+/**
+* @class Array
+* In-memory JSON array.
+*/
+class Array : public Container<Json::IArray, size_t>
+{
+public:
+	void clear(void) override;
+	size_t getSize(void) const override;
+	void remove(size_t index) override;
+
+	/**
+	* @fn clone
+	* Deep copy the array.
+	* @return std::unique_ptr<Array>: the copy
+	*/
+	std::unique_ptr<Array> clone(void) const;
+
+protected:
+	const Value* find(size_t index) const override;
+	Value& at(size_t index) override;
+
+private:
+	std::vector<Value> m_values;
+};
+
+/**
+* @class Conf
+* In-memory module configuration. `read` deep copies the object, as a JSON file backed configuration does,
+* while `snapshot` shares the current immutable object.
+*/
+class Conf : public IConf
+{
+public:
+	Conf(void);
+
+	std::unique_ptr<Json::IObject> read(void) const override;
+	void write(const Json::IObject &jsonObject) override;
+	std::shared_ptr<const Json::IObject> snapshot(void) const override;
+	uint64_t getGeneration(void) const override;
+
+	/**
+	* @fn edit
+	* Get the configuration for edition. Bumps the generation.
+	* @return Object&: the configuration object
+	*/
+	Object& edit(void);
+
+private:
+	std::shared_ptr<Object> m_object;
+	uint64_t m_generation;
+};
+
+}
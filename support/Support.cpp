@@ -0,0 +1,147 @@
+#include "Support.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace Zia::Support {
+
+MemoryInput::MemoryInput(const std::string &data, size_t fragmentSize) :
+	m_data(data),
+	m_fragmentSize(fragmentSize),
+	m_pos(0),
+	m_end(0)
+{
+}
+
+size_t MemoryInput::read(size_t buf_size, char *buf)
+{
+	size_t res = std::min(buf_size, m_end - m_pos);
+
+	std::memcpy(buf, m_data.data() + m_pos, res);
+	m_pos += res;
+	return res;
+}
+
+bool MemoryInput::feed(void)
+{
+	return feed(m_fragmentSize);
+}
+
+bool MemoryInput::feed(size_t size)
+{
+	if (m_end == m_data.size())
+		return false;
+	m_end = std::min(m_end + size, m_data.size());
+	return true;
+}
+
+bool MemoryInput::isOver(void) const
+{
+	return m_pos == m_data.size();
+}
+
+NullOutput::NullOutput(void) :
+	m_written(0)
+{
+}
+
+size_t NullOutput::write(size_t buf_size, const char *buf)
+{
+	static_cast<void>(buf);
+	m_written += buf_size;
+	return buf_size;
+}
+
+size_t NullOutput::writev(size_t bufs_count, const ConstBuffer *bufs)
+{
+	size_t res = 0;
+
+	for (size_t i = 0; i < bufs_count; i++)
+		res += bufs[i].size;
+	m_written += res;
+	return res;
+}
+
+uint64_t NullOutput::getWritten(void) const
+{
+	return m_written;
+}
+
+void NullLogger::log(const std::string &str)
+{
+	std::fprintf(stderr, "%s\n", str.c_str());
+}
+
+LogLevel NullLogger::getMinLevel(void) const
+{
+	return LogLevel::Error;
+}
+
+CapturingEmitter::CapturingEmitter(size_t keep, IBufferPool *pool) :
+	m_keep(keep),
+	m_pool(pool),
+	m_storage(64 * 1024),
+	m_arena(m_storage.data(), m_storage.size()),
+	m_count(0),
+	m_unowned(0),
+	m_wakes(0)
+{
+}
+
+void CapturingEmitter::emit(const IRequest &request)
+{
+	// Not kept: only valid during the call
+	static_cast<void>(request);
+	m_count++;
+	m_unowned++;
+}
+
+void CapturingEmitter::emit(std::unique_ptr<IRequest> request)
+{
+	m_count++;
+	if (m_requests.size() < m_keep) {
+		m_requests.push_back(std::move(request));
+		return;
+	}
+	request.reset();
+	if (m_requests.empty())
+		m_arena.release();
+}
+
+std::pmr::memory_resource& CapturingEmitter::getArena(void)
+{
+	return m_arena;
+}
+
+void CapturingEmitter::wake(void)
+{
+	m_wakes++;
+}
+
+IBufferPool* CapturingEmitter::getBufferPool(void)
+{
+	return m_pool;
+}
+
+const std::vector<std::unique_ptr<IRequest>>& CapturingEmitter::getRequests(void) const
+{
+	return m_requests;
+}
+
+size_t CapturingEmitter::getCount(void) const
+{
+	return m_count;
+}
+
+size_t CapturingEmitter::getUnownedCount(void) const
+{
+	return m_unowned;
+}
+
+size_t CapturingEmitter::getWakeCount(void) const
+{
+	return m_wakes;
+}
+
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "zia/Zia.hpp"
+
+/** @file
+ * Fixtures shared by the checks and benchmarks of the reference modules: in-memory client streams,
+ * a quiet logger and a request emitter keeping what parsers emit.
+*/
+
+/**
+* @namespace Zia::Support
+* Check and benchmark fixtures.
+*/
+namespace Zia::Support {
+
+/**
+* @class MemoryInput
+* Client input replayed from memory. Bytes come in by fragments, as they would from a socket:
+* once a fragment is read, reads return 0 until the next one is fed.
+*/
+class MemoryInput : public IInput
+{
+public:
+	/**
+	* @fn MemoryInput
+	* Create an input.
+	* @param const std::string &data: the bytes sent by the client, must outlive the input
+	* @param size_t fragmentSize: the amount of bytes coming in at once
+	*/
+	MemoryInput(const std::string &data, size_t fragmentSize);
+
+	size_t read(size_t buf_size, char *buf) override;
+
+	/**
+	* @fn feed
+	* Make the next fragment available.
+	* @return bool: false if all bytes were read already
+	*/
+	bool feed(void);
+
+	/**
+	* @fn feed
+	* Make the next bytes available, whatever the fragment size.
+	* @param size_t size: the amount of bytes coming in
+	* @return bool: false if all bytes were read already
+	*/
+	bool feed(size_t size);
+
+	/**
+	* @fn isOver
+	* Check whether all bytes were read.
+	* @return bool: true if all bytes were read
+	*/
+	bool isOver(void) const;
+
+private:
+	const std::string &m_data;
+	size_t m_fragmentSize;
+	size_t m_pos; ///< First byte not read yet
+	size_t m_end; ///< Past the last byte available
+};
+
+/**
+* @class NullOutput
+* Client output discarding bytes, only counting them.
+*/
+class NullOutput : public IOutput
+{
+public:
+	NullOutput(void);
+
+	size_t write(size_t buf_size, const char *buf) override;
+	size_t writev(size_t bufs_count, const ConstBuffer *bufs) override;
+
+	uint64_t getWritten(void) const;
+
+private:
+	uint64_t m_written;
+};
+
+/**
+* @class NullLogger
+* Logger discarding records below the error level, and printing others to stderr.
+*/
+class NullLogger : public ILogger
+{
+public:
+	void log(const std::string &str) override;
+	LogLevel getMinLevel(void) const override;
+};
+
+/**
+* @class CapturingEmitter
+* Request emitter keeping the first requests emitted by std::unique_ptr, and counting the others.
+* Requests are allocated from a single arena, released once no request is kept.
+*/
+class CapturingEmitter : public IRequest::IEmitter
+{
+public:
+	/**
+	* @fn CapturingEmitter
+	* Create an emitter.
+	* @param size_t keep: the amount of requests kept, further ones are destroyed right away
+	* @param IBufferPool *pool: the pool handed to parsers, nullptr for none
+	*/
+	explicit CapturingEmitter(size_t keep, IBufferPool *pool = nullptr);
+
+	void emit(const IRequest &request) override;
+	void emit(std::unique_ptr<IRequest> request) override;
+	std::pmr::memory_resource& getArena(void) override;
+	void wake(void) override;
+	IBufferPool* getBufferPool(void) override;
+
+	/**
+	* @fn getRequests
+	* Get the kept requests.
+	* @return const std::vector<std::unique_ptr<IRequest>>&: the kept requests, in emission order
+	*/
+	const std::vector<std::unique_ptr<IRequest>>& getRequests(void) const;
+
+	/**
+	* @fn getCount
+	* Get the amount of emitted requests, kept or not.
+	* @return size_t: the request count
+	*/
+	size_t getCount(void) const;
+
+	/**
+	* @fn getUnownedCount
+	* Get the amount of requests emitted by reference.
+	* @return size_t: the request count
+	*/
+	size_t getUnownedCount(void) const;
+
+	/**
+	* @fn getWakeCount
+	* Get the amount of `wake` calls.
+	* @return size_t: the wake count
+	*/
+	size_t getWakeCount(void) const;
+
+private:
+	size_t m_keep;
+	IBufferPool *m_pool;
+	std::vector<char> m_storage;
+	std::pmr::monotonic_buffer_resource m_arena;
+	std::vector<std::unique_ptr<IRequest>> m_requests; ///< Declared after their arena, to be destroyed first
+	size_t m_count;
+	size_t m_unowned;
+	size_t m_wakes;
+};
+
+}